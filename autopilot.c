@@ -0,0 +1,92 @@
+#include "autopilot.h"
+
+#include <math.h>
+#include <string.h>
+
+static const char *AUTOPILOT_NAMES[NUM_AUTOPILOTS] = { "track", "predict" };
+
+// Limit a requested paddle movement to what a key press can do in a step
+static float clampPaddleMove(float delta) {
+    if (delta > PADDLE_SPEED) {
+        return PADDLE_SPEED;
+    }
+    if (delta < -PADDLE_SPEED) {
+        return -PADDLE_SPEED;
+    }
+    return delta;
+}
+
+// The ball the paddle should look after: the first one due to come down
+// to it, or the lowest one if all are heading up
+static const Ball *nextBallToLand(const GameState *game) {
+    const Ball *best = &game->balls[0];
+    float bestTime = INFINITY;
+    for (int b = 0; b < game->numBalls; ++b) {
+        const Ball *ball = &game->balls[b];
+        float time = ball->dy > 0 ? (game->paddle.y - ball->size - ball->y) / ball->dy
+                                  : (game->paddle.y + ball->y) / -ball->dy;
+        if (time < bestTime) {
+            bestTime = time;
+            best = ball;
+        }
+    }
+    return best;
+}
+
+// Simple autoplay: move the paddle centre towards the ball
+static GameInput trackBall(const GameState *game) {
+    GameInput input = { 0 };
+    const Ball *ball = nextBallToLand(game);
+    float target = ball->x + ball->size / 2 - game->paddle.width / 2;
+    input.paddleDx = clampPaddleMove(target - game->paddle.x);
+    return input;
+}
+
+// Predictive autoplay: move the paddle under the point where the ball will
+// come down, folding its path at the side walls and ignoring bricks. The
+// target only changes when the ball bounces, so the input stays idle for
+// long stretches.
+static GameInput predictLanding(const GameState *game) {
+    GameInput input = { 0 };
+    const Ball *ball = nextBallToLand(game);
+    float landingY = game->paddle.y - ball->size;
+    float distance = ball->dy > 0 ? landingY - ball->y : ball->y + landingY;
+    float x = ball->x + ball->dx * fabsf(distance / ball->dy);
+
+    // Unfold reflections off the side walls
+    float span = SCREEN_WIDTH - ball->size;
+    x = fmodf(x, 2 * span);
+    if (x < 0) {
+        x += 2 * span;
+    }
+    if (x > span) {
+        x = 2 * span - x;
+    }
+
+    // Centre the paddle there, as far as the screen edges allow
+    float target = x + ball->size / 2 - game->paddle.width / 2;
+    target = fmaxf(0.f, fminf(target, SCREEN_WIDTH - game->paddle.width));
+    float delta = target - game->paddle.x;
+    if (fabsf(delta) >= 0.5f) {
+        input.paddleDx = clampPaddleMove(delta);
+    }
+    return input;
+}
+
+GameInput autopilotInput(Autopilot autopilot, const GameState *game) {
+    return autopilot == AUTOPILOT_PREDICT ? predictLanding(game) : trackBall(game);
+}
+
+const char *autopilotName(Autopilot autopilot) {
+    return AUTOPILOT_NAMES[autopilot];
+}
+
+bool parseAutopilot(const char *name, Autopilot *autopilot) {
+    for (int a = 0; a < NUM_AUTOPILOTS; ++a) {
+        if (strcmp(name, AUTOPILOT_NAMES[a]) == 0) {
+            *autopilot = (Autopilot)a;
+            return true;
+        }
+    }
+    return false;
+}
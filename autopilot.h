@@ -0,0 +1,23 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include <stdbool.h>
+
+#include "game.h"
+
+// Built-in paddle policies. Each looks only at the game state and asks for
+// at most a key press worth of movement (PADDLE_SPEED) per step.
+typedef enum {
+    AUTOPILOT_TRACK,    // Keep the paddle centre under the ball
+    AUTOPILOT_PREDICT,  // Wait where the ball will land, idle between bounces
+    NUM_AUTOPILOTS
+} Autopilot;
+
+GameInput autopilotInput(Autopilot autopilot, const GameState *game);
+
+const char *autopilotName(Autopilot autopilot);
+
+// Parse "track" or "predict"; false if unknown
+bool parseAutopilot(const char *name, Autopilot *autopilot);
+
+#endif
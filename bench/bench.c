@@ -0,0 +1,641 @@
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "env.h"
+#include "game.h"
+#include "leaderboard.h"
+#include "level.h"
+#include "particles.h"
+#include "render.h"
+#include "text.h"
+
+// Micro and macro benchmarks. Each benchmark is timed as a series of
+// samples; a sample runs the operation enough times to take at least
+// MIN_SAMPLE_SECONDS (once for frame-sized work), and the per-operation
+// times of the samples give the mean and percentiles.
+
+static const double MIN_SAMPLE_SECONDS = 20e-6;
+
+typedef void (*BenchFunction)(void *context, long iterations);
+
+typedef struct {
+    const char *name;
+    long iterations;  // Total operations timed
+    double mean, p50, p90, p99, min, max;  // Nanoseconds per operation
+} BenchResult;
+
+#define MAX_RESULTS 64
+
+static BenchResult results[MAX_RESULTS];
+static int numResults = 0;
+static int numSamples = 200;
+static const char *filter = NULL;
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static double percentile(const double *sorted, int count, double p) {
+    int index = (int)(p * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+// Time function over numSamples samples and record the result
+static void runBenchmark(const char *name, BenchFunction function, void *context) {
+    if (filter && !strstr(name, filter)) {
+        return;
+    }
+    if (numResults == MAX_RESULTS) {
+        printf("Too many benchmarks, %s skipped\n", name);
+        return;
+    }
+
+    // Warm up and pick the batch size
+    long batch = 1;
+    for (;;) {
+        double start = nowSeconds();
+        function(context, batch);
+        if (nowSeconds() - start >= MIN_SAMPLE_SECONDS || batch >= (1L << 24)) {
+            break;
+        }
+        batch *= 2;
+    }
+
+    double *samples = malloc(sizeof(double) * numSamples);
+    if (!samples) {
+        printf("Failed to allocate samples!\n");
+        return;
+    }
+    double total = 0.0;
+    for (int s = 0; s < numSamples; ++s) {
+        double start = nowSeconds();
+        function(context, batch);
+        samples[s] = (nowSeconds() - start) * 1e9 / batch;
+        total += samples[s];
+    }
+    qsort(samples, numSamples, sizeof(double), compareDoubles);
+
+    BenchResult *result = &results[numResults++];
+    result->name = name;
+    result->iterations = batch * numSamples;
+    result->mean = total / numSamples;
+    result->p50 = percentile(samples, numSamples, 0.50);
+    result->p90 = percentile(samples, numSamples, 0.90);
+    result->p99 = percentile(samples, numSamples, 0.99);
+    result->min = samples[0];
+    result->max = samples[numSamples - 1];
+    free(samples);
+
+    printf("%-36s %12.1f %12.1f %12.1f %12.1f %12ld\n", name, result->mean, result->p50,
+           result->p90, result->p99, result->iterations);
+}
+
+static bool writeJson(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        printf("Failed to open %s for writing!\n", path);
+        return false;
+    }
+    fprintf(file, "{\n  \"timestamp\": %lld,\n  \"brick_kernel\": \"%s\",\n  \"particle_kernel\": \"%s\",\n"
+                  "  \"results\": [\n",
+            (long long)time(NULL), brickKernelName(), particleKernelName());
+    for (int r = 0; r < numResults; ++r) {
+        const BenchResult *result = &results[r];
+        fprintf(file, "    {\"name\": \"%s\", \"iterations\": %ld, \"ns_per_op\": %.2f, "
+                      "\"p50\": %.2f, \"p90\": %.2f, \"p99\": %.2f, \"min\": %.2f, \"max\": %.2f}%s\n",
+                result->name, result->iterations, result->mean, result->p50, result->p90,
+                result->p99, result->min, result->max, r + 1 < numResults ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+// xorshift32 for reproducible inputs
+static uint32_t benchRandom(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static float randomRange(uint32_t *state, float low, float high) {
+    return low + (high - low) * (benchRandom(state) >> 8) * (1.f / 16777216.f);
+}
+
+// Balls scattered over the brick field, cycled through by the collision
+// benchmarks so results do not hinge on one lucky position
+#define NUM_PROBES 1024
+
+typedef struct {
+    GameState game;
+    Ball probes[NUM_PROBES];
+    float dt;
+    int next;
+    volatile int sink;  // Keeps results alive
+} CollisionBench;
+
+// The built-in level, as a lattice or with explicit geometry and a grid
+static bool initCollisionBench(CollisionBench *bench, int numBricks, bool lattice) {
+    if (lattice) {
+        if (!initGame(&bench->game, numBricks)) {
+            return false;
+        }
+    } else {
+        BrickStore bricks;
+        if (!initBrickStore(&bricks, numBricks)) {
+            return false;
+        }
+        initBricks(&bricks);
+        if (!initGameWithBricks(&bench->game, &bricks)) {
+            return false;
+        }
+    }
+    const BrickStore *bricks = &bench->game.bricks;
+    float maxY = 0;
+    for (int i = 0; i < bricks->count; ++i) {
+        if (brickY(bricks, i) + brickHeight(bricks, i) > maxY) {
+            maxY = brickY(bricks, i) + brickHeight(bricks, i);
+        }
+    }
+    uint32_t rng = 12345;
+    for (int p = 0; p < NUM_PROBES; ++p) {
+        Ball *ball = &bench->probes[p];
+        initBall(ball);
+        ball->x = randomRange(&rng, 0, SCREEN_WIDTH - ball->size);
+        ball->y = randomRange(&rng, 0, maxY);
+        ball->dx = randomRange(&rng, -BALL_SPEED, BALL_SPEED);
+        ball->dy = randomRange(&rng, -BALL_SPEED, BALL_SPEED);
+    }
+    bench->dt = 1.f / PHYSICS_HZ;
+    bench->next = 0;
+    return true;
+}
+
+static void benchCheckCollision(void *context, long iterations) {
+    CollisionBench *bench = context;
+    int hits = 0;
+    for (long n = 0; n < iterations; ++n) {
+        const Ball *ball = &bench->probes[n & (NUM_PROBES - 1)];
+        hits += checkCollision(ball, &bench->game.bricks, (int)(n % bench->game.bricks.count));
+    }
+    bench->sink = hits;
+}
+
+static void benchBrickCollisions(void *context, long iterations) {
+    CollisionBench *bench = context;
+    int hits = 0;
+    for (long n = 0; n < iterations; ++n) {
+        Ball ball = bench->probes[bench->next];
+        bench->next = (bench->next + 1) & (NUM_PROBES - 1);
+        BallHits ballHits = { .count = 0, .lost = false };
+        if (handleBallBrickCollisions(&bench->game, &ball, bench->dt, &ballHits) >= 0) {
+            hits++;
+        }
+    }
+    bench->sink = hits;
+}
+
+// Rendering into a software renderer, so results do not depend on a GPU
+typedef struct {
+    SDL_Surface *surface;
+    SDL_Renderer *renderer;
+    RectBatch batch;
+    GlyphAtlas *atlas;  // NULL without a font
+    BrickLayer layer;
+    GameState game;
+} DrawBench;
+
+static const SDL_Color WHITE = {255, 255, 255, 255};
+static const SDL_Color RED = {255, 0, 0, 255};
+
+static void benchDrawShapes(void *context, long iterations) {
+    DrawBench *bench = context;
+    for (long n = 0; n < iterations; ++n) {
+        drawPaddle(&bench->batch, &bench->game.paddle, WHITE);
+        drawBall(&bench->batch, &bench->game.balls[0], WHITE);
+        flushRects(&bench->batch, bench->renderer);
+    }
+}
+
+static void benchDrawBricks(void *context, long iterations) {
+    DrawBench *bench = context;
+    for (long n = 0; n < iterations; ++n) {
+        drawBricks(&bench->batch, &bench->game.bricks, RED);
+        flushRects(&bench->batch, bench->renderer);
+    }
+}
+
+static void benchBrickLayer(void *context, long iterations) {
+    DrawBench *bench = context;
+    for (long n = 0; n < iterations; ++n) {
+        updateBrickLayer(&bench->layer, &bench->batch, &bench->game.bricks, &bench->game.brickEvents);
+        drawBrickLayer(&bench->layer, &bench->batch, &bench->game.bricks);
+        clearBrickEvents(&bench->game);
+    }
+}
+
+static void benchDisplayText(void *context, long iterations) {
+    DrawBench *bench = context;
+    for (long n = 0; n < iterations; ++n) {
+        displayText(bench->atlas, "Score: 1234", WHITE, 20, 700);
+        displayText(bench->atlas, "Best Score: 5678", WHITE, SCREEN_WIDTH - 220, 700);
+        flushText(bench->atlas);
+    }
+}
+
+// One whole frame: physics step plus everything main draws
+static void benchFrame(void *context, long iterations) {
+    DrawBench *bench = context;
+    GameInput input = { 0 };
+    char scoreText[100];
+    for (long n = 0; n < iterations; ++n) {
+        if (bench->game.gameOver) {
+            resetGame(&bench->game);
+        }
+        stepGame(&bench->game, &input, 1.f / PHYSICS_HZ);
+        SDL_SetRenderDrawColor(bench->renderer, 0, 0, 0, 255);
+        SDL_RenderClear(bench->renderer);
+        updateBrickLayer(&bench->layer, &bench->batch, &bench->game.bricks, &bench->game.brickEvents);
+        drawBrickLayer(&bench->layer, &bench->batch, &bench->game.bricks);
+        clearBrickEvents(&bench->game);
+        drawPaddle(&bench->batch, &bench->game.paddle, WHITE);
+        for (int b = 0; b < bench->game.numBalls; ++b) {
+            drawBall(&bench->batch, &bench->game.balls[b], WHITE);
+        }
+        flushRects(&bench->batch, bench->renderer);
+        if (bench->atlas) {
+            sprintf(scoreText, "Score: %d", bench->game.score);
+            displayText(bench->atlas, scoreText, WHITE, 20, 700);
+            flushText(bench->atlas);
+        }
+        SDL_RenderPresent(bench->renderer);
+    }
+}
+
+static bool initDrawBench(DrawBench *bench, int numBricks) {
+    memset(bench, 0, sizeof(*bench));
+    bench->surface = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!bench->surface) {
+        printf("Failed to create render surface! SDL_Error: %s\n", SDL_GetError());
+        return false;
+    }
+    bench->renderer = SDL_CreateSoftwareRenderer(bench->surface);
+    if (!bench->renderer) {
+        printf("Failed to create software renderer! SDL_Error: %s\n", SDL_GetError());
+        SDL_FreeSurface(bench->surface);
+        return false;
+    }
+    if (!initRectBatch(&bench->batch, numBricks + 16) ||
+        !createBrickLayer(&bench->layer, bench->renderer, SCREEN_WIDTH, SCREEN_HEIGHT, RED) ||
+        !initGame(&bench->game, numBricks)) {
+        freeRectBatch(&bench->batch);
+        SDL_DestroyRenderer(bench->renderer);
+        SDL_FreeSurface(bench->surface);
+        return false;
+    }
+    return true;
+}
+
+static void freeDrawBench(DrawBench *bench) {
+    freeGame(&bench->game);
+    destroyBrickLayer(&bench->layer);
+    freeRectBatch(&bench->batch);
+    SDL_DestroyRenderer(bench->renderer);
+    SDL_FreeSurface(bench->surface);
+}
+
+// Rendering benchmarks at two level sizes, each against its own renderer
+static void runDrawBenchmarks(const char *fontPath) {
+    static const int brickCounts[] = { NUM_BRICKS, 10000 };
+    static const char *names[][3] = {
+        { "draw/bricks/20", "draw/brick_layer/20", "frame/20" },
+        { "draw/bricks/10k", "draw/brick_layer/10k", "frame/10k" },
+    };
+    static GlyphAtlas atlas;
+    TTF_Font *font = TTF_OpenFont(fontPath, 28);
+    if (!font) {
+        printf("Font %s not found, text benchmarks skipped\n", fontPath);
+    }
+
+    DrawBench draw;
+    for (int d = 0; d < 2; ++d) {
+        if (!initDrawBench(&draw, brickCounts[d])) {
+            break;
+        }
+        // The atlas texture belongs to one renderer, so build it per level
+        if (font && createGlyphAtlas(&atlas, draw.renderer, font)) {
+            draw.atlas = &atlas;
+        }
+        if (d == 0) {
+            runBenchmark("draw/paddle_ball", benchDrawShapes, &draw);
+            if (draw.atlas) {
+                runBenchmark("displayText", benchDisplayText, &draw);
+            }
+        }
+        runBenchmark(names[d][0], benchDrawBricks, &draw);
+        runBenchmark(names[d][1], benchBrickLayer, &draw);
+        runBenchmark(names[d][2], benchFrame, &draw);
+        if (draw.atlas) {
+            destroyGlyphAtlas(draw.atlas);
+        }
+        freeDrawBench(&draw);
+    }
+
+    if (font) {
+        TTF_CloseFont(font);
+    }
+}
+
+// A batch of training environments steered towards the ball; one
+// operation is a step of the whole batch
+#define BENCH_ENVS 4096
+
+typedef struct {
+    EnvBatch *batch;
+    int obsSize;
+    float *observations, *actions, *rewards;
+    uint8_t *dones;
+} EnvBench;
+
+static void benchEnvStep(void *context, long iterations) {
+    EnvBench *bench = context;
+    for (long n = 0; n < iterations; ++n) {
+        for (int e = 0; e < BENCH_ENVS; ++e) {
+            const float *row = &bench->observations[(size_t)e * bench->obsSize];
+            float ballCentre = row[ENV_OBS_BALL_X] + BALL_SIZE / 2.f / SCREEN_WIDTH;
+            float paddleCentre = row[ENV_OBS_PADDLE_X] + PADDLE_WIDTH / 2.f / SCREEN_WIDTH;
+            bench->actions[e] = ballCentre < paddleCentre ? -1.f : 1.f;
+        }
+        stepEnvs(bench->batch, bench->actions, bench->observations, bench->rewards, bench->dones);
+    }
+}
+
+static void runEnvBenchmarks(void) {
+    static const int threadCounts[] = { 1, 0 };
+    static const char *names[] = { "env/step/4096/1thread", "env/step/4096/all_threads" };
+    for (int t = 0; t < 2; ++t) {
+        EnvSettings settings = { BENCH_ENVS, NUM_BRICKS, 0.f, 1, 0, threadCounts[t] };
+        EnvBench bench;
+        bench.batch = createEnvBatch(&settings);
+        if (!bench.batch) {
+            return;
+        }
+        bench.obsSize = envObservationSize(bench.batch);
+        bench.observations = malloc(sizeof(float) * BENCH_ENVS * bench.obsSize);
+        bench.actions = malloc(sizeof(float) * BENCH_ENVS);
+        bench.rewards = malloc(sizeof(float) * BENCH_ENVS);
+        bench.dones = malloc(BENCH_ENVS);
+        if (bench.observations && bench.actions && bench.rewards && bench.dones) {
+            resetEnvs(bench.batch, bench.observations);
+            runBenchmark(names[t], benchEnvStep, &bench);
+        }
+        free(bench.observations);
+        free(bench.actions);
+        free(bench.rewards);
+        free(bench.dones);
+        destroyEnvBatch(bench.batch);
+    }
+}
+
+// Debris from many bricks at once; particles never expire, so every
+// sample moves the same number
+#define BENCH_PARTICLES 100000
+
+typedef struct {
+    ParticlePool pool;
+    RectBatch batch;
+} ParticleBench;
+
+static void benchUpdateParticles(void *context, long iterations) {
+    ParticleBench *bench = context;
+    for (long i = 0; i < iterations; ++i) {
+        updateParticles(&bench->pool, 1.f / 144);
+    }
+}
+
+static void benchQueueParticles(void *context, long iterations) {
+    ParticleBench *bench = context;
+    for (long i = 0; i < iterations; ++i) {
+        drawParticles(&bench->batch, &bench->pool);
+        bench->batch.numRects = 0;
+    }
+}
+
+static void runParticleBenchmarks(void) {
+    static ParticleBench bench;
+    if (!initParticlePool(&bench.pool, BENCH_PARTICLES)) {
+        return;
+    }
+    if (!initRectBatch(&bench.batch, BENCH_PARTICLES)) {
+        freeParticlePool(&bench.pool);
+        return;
+    }
+    while (bench.pool.count < BENCH_PARTICLES) {
+        spawnDebris(&bench.pool, 100.f, 100.f, BRICK_WIDTH, BRICK_HEIGHT, 0xFF0000FF, DEBRIS_PER_BRICK);
+    }
+    for (int i = 0; i < bench.pool.count; ++i) {
+        bench.pool.life[i] = 1e9f;
+    }
+    runBenchmark("particles/update/100k", benchUpdateParticles, &bench);
+    runBenchmark("particles/queue/100k", benchQueueParticles, &bench);
+    freeRectBatch(&bench.batch);
+    freeParticlePool(&bench.pool);
+}
+
+// Leaderboard with a long history of games by many players
+#define BENCH_PLAYERS 10000
+
+typedef struct {
+    Leaderboard *board;
+    char names[BENCH_PLAYERS][MAX_PLAYER_NAME];
+    uint32_t rng;
+    int next;
+} LeaderboardBench;
+
+static void benchAddScore(void *context, long iterations) {
+    LeaderboardBench *bench = context;
+    for (long i = 0; i < iterations; ++i) {
+        uint32_t r = benchRandom(&bench->rng);
+        addScore(bench->board, bench->names[r % BENCH_PLAYERS], (int)(r >> 24) % 16, (int)(r >> 8) % 100000, 0);
+    }
+}
+
+static void benchTopScores(void *context, long iterations) {
+    LeaderboardBench *bench = context;
+    ScoreEntry top[10];
+    for (long i = 0; i < iterations; ++i) {
+        topScores(bench->board, bench->next++ & 15, top, 10);
+    }
+}
+
+static void benchPlayerBest(void *context, long iterations) {
+    LeaderboardBench *bench = context;
+    ScoreEntry entry;
+    for (long i = 0; i < iterations; ++i) {
+        bench->next = (bench->next + 1) % BENCH_PLAYERS;
+        playerBest(bench->board, bench->names[bench->next], bench->next & 15, &entry);
+    }
+}
+
+static void benchOpenLeaderboard(void *context, long iterations) {
+    const char *path = context;
+    for (long i = 0; i < iterations; ++i) {
+        closeLeaderboard(openLeaderboard(path));
+    }
+}
+
+static void runLeaderboardBenchmarks(void) {
+    static const char *path = "bench_scores.dat";
+    static LeaderboardBench bench;
+    remove(path);
+    bench.board = openLeaderboard(path);
+    if (!bench.board) {
+        return;
+    }
+    for (int p = 0; p < BENCH_PLAYERS; ++p) {
+        sprintf(bench.names[p], "player%d", p);
+    }
+    bench.rng = 12345;
+    benchAddScore(&bench, 1000000);
+    runBenchmark("leaderboard/add/1M", benchAddScore, &bench);
+    runBenchmark("leaderboard/top10/1M", benchTopScores, &bench);
+    runBenchmark("leaderboard/player_best/1M", benchPlayerBest, &bench);
+    closeLeaderboard(bench.board);
+    runBenchmark("leaderboard/open/1M", benchOpenLeaderboard, (void *)path);
+    remove(path);
+}
+
+// Level file with a million bricks in rows, as written by makelevel --grid
+#define BENCH_LEVEL_COLS 1000
+
+static void benchLoadLevel(void *context, long iterations) {
+    const char *path = context;
+    for (long i = 0; i < iterations; ++i) {
+        Level *level = openLevel(path);
+        BrickStore bricks;
+        GameState game;
+        if (level && initLevelBricks(level, &bricks) && initGameWithBricks(&game, &bricks)) {
+            freeGame(&game);
+        }
+        closeLevel(level);
+    }
+}
+
+static void runLevelBenchmarks(void) {
+    static const char *path = "bench_level.lvl";
+    int count = BENCH_LEVEL_COLS * BENCH_LEVEL_COLS;
+    int32_t *fields = malloc(sizeof(int32_t) * 4 * (size_t)count);
+    if (!fields) {
+        return;
+    }
+    LevelData data = { count, fields, fields + count, fields + 2 * (size_t)count, fields + 3 * (size_t)count,
+                       NULL, NULL, 0, NULL };
+    for (int i = 0; i < count; ++i) {
+        fields[i] = i % BENCH_LEVEL_COLS * (BRICK_WIDTH + 5) + 15;
+        fields[count + i] = i / BENCH_LEVEL_COLS * (BRICK_HEIGHT + 5) + 15;
+        fields[2 * count + i] = BRICK_WIDTH;
+        fields[3 * count + i] = BRICK_HEIGHT;
+    }
+    bool saved = saveLevel(path, &data);
+    free(fields);
+    if (saved) {
+        runBenchmark("level/load/1M", benchLoadLevel, (void *)path);
+    }
+    remove(path);
+}
+
+static void printUsage(const char *program) {
+    printf("usage: %s [--filter TEXT] [--samples N] [--json FILE] [--font FILE]\n"
+           "  --filter TEXT  only run benchmarks whose name contains TEXT\n"
+           "  --samples N    timed samples per benchmark (default 200)\n"
+           "  --json FILE    also write the results as JSON\n"
+           "  --font FILE    font for the text benchmarks (default Minecraft.ttf)\n",
+           program);
+}
+
+int main(int argc, char* argv[])
+{
+    const char *jsonPath = NULL;
+    const char *fontPath = "Minecraft.ttf";
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            numSamples = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (strcmp(argv[i], "--font") == 0 && i + 1 < argc) {
+            fontPath = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (numSamples < 1) {
+        numSamples = 1;
+    }
+
+    printf("%-36s %12s %12s %12s %12s %12s\n", "benchmark (ns/op)", "mean", "p50", "p90", "p99", "ops");
+
+    // Physics
+    static const int brickCounts[] = { 20, 1000, 100000, 1000000 };
+    static const char *collisionNames[][3] = {
+        { "collide/grid/20", "collide/brute/20", "collide/lattice/20" },
+        { "collide/grid/1k", "collide/brute/1k", "collide/lattice/1k" },
+        { "collide/grid/100k", "collide/brute/100k", "collide/lattice/100k" },
+        { "collide/grid/1M", "collide/brute/1M", "collide/lattice/1M" },
+    };
+    static CollisionBench collision;
+    for (int c = 0; c < 4; ++c) {
+        if (!initCollisionBench(&collision, brickCounts[c], false)) {
+            printf("Failed to allocate %d bricks!\n", brickCounts[c]);
+            return 1;
+        }
+        if (c == 0) {
+            runBenchmark("checkCollision", benchCheckCollision, &collision);
+        }
+        collision.game.collisionMode = COLLIDE_GRID;
+        runBenchmark(collisionNames[c][0], benchBrickCollisions, &collision);
+        collision.game.collisionMode = COLLIDE_BRUTE_FORCE;
+        runBenchmark(collisionNames[c][1], benchBrickCollisions, &collision);
+        freeGame(&collision.game);
+        if (!initCollisionBench(&collision, brickCounts[c], true)) {
+            printf("Failed to allocate %d bricks!\n", brickCounts[c]);
+            return 1;
+        }
+        runBenchmark(collisionNames[c][2], benchBrickCollisions, &collision);
+        freeGame(&collision.game);
+    }
+    runEnvBenchmarks();
+    runParticleBenchmarks();
+
+    // Persistence
+    runLeaderboardBenchmarks();
+    runLevelBenchmarks();
+
+    // Rendering
+    if (SDL_Init(0) < 0 || TTF_Init() == -1) {
+        printf("SDL could not initialize, rendering benchmarks skipped. SDL_Error: %s\n", SDL_GetError());
+    } else {
+        runDrawBenchmarks(fontPath);
+        TTF_Quit();
+        SDL_Quit();
+    }
+
+    if (jsonPath && !writeJson(jsonPath)) {
+        return 1;
+    }
+    return 0;
+}
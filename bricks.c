@@ -0,0 +1,313 @@
+#include "bricks.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BRICKS_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+typedef int (*BrickOverlapKernel)(const BrickStore *store, int first, int32_t minX, int32_t minY,
+                                  int32_t maxX, int32_t maxY, int *out, int maxOut);
+
+static BrickOverlapKernel overlapKernel = NULL;
+static const char *overlapKernelName = "none";
+
+// Sizes and the active mask shared by both kinds of store
+static bool initStoreShape(BrickStore *store, int count) {
+    int capacity = (count + BRICK_BLOCK - 1) / BRICK_BLOCK * BRICK_BLOCK;
+    if (capacity == 0) {
+        capacity = BRICK_BLOCK;
+    }
+    memset(store, 0, sizeof(*store));
+    store->count = count;
+    store->capacity = capacity;
+    store->numWords = (capacity + 63) / 64;
+    store->active = calloc(store->numWords, sizeof(uint64_t));
+
+    // Pick the overlap kernel while still single threaded
+    if (!overlapKernel) {
+        selectBrickKernel(NULL);
+    }
+    return store->active != NULL;
+}
+
+bool initBrickStore(BrickStore *store, int count) {
+    if (!initStoreShape(store, count)) {
+        return false;
+    }
+    int capacity = store->capacity;
+    store->x = calloc(capacity, sizeof(int32_t));
+    store->y = calloc(capacity, sizeof(int32_t));
+    store->width = calloc(capacity, sizeof(int32_t));
+    store->height = calloc(capacity, sizeof(int32_t));
+    if (!store->x || !store->y || !store->width || !store->height) {
+        freeBrickStore(store);
+        return false;
+    }
+    return true;
+}
+
+bool initBrickStoreView(BrickStore *store, int count, const int32_t *x, const int32_t *y,
+                        const int32_t *width, const int32_t *height) {
+    if (!initStoreShape(store, count)) {
+        return false;
+    }
+    // Never written through: the game only changes the active mask
+    store->x = (int32_t *)x;
+    store->y = (int32_t *)y;
+    store->width = (int32_t *)width;
+    store->height = (int32_t *)height;
+    store->borrowed = true;
+    activateAllBricks(store);
+    return true;
+}
+
+bool initBrickLattice(BrickStore *store, int count, const BrickLattice *lattice) {
+    // Bricks must not overlap, so a box query maps to one block of cells
+    if (lattice->cols < 1 || lattice->width < 1 || lattice->height < 1 ||
+        lattice->width > lattice->pitchX || lattice->height > lattice->pitchY) {
+        return false;
+    }
+    if (!initStoreShape(store, count)) {
+        return false;
+    }
+    store->lattice = *lattice;
+    activateAllBricks(store);
+    return true;
+}
+
+void freeBrickStore(BrickStore *store) {
+    if (!store->borrowed) {
+        free(store->x);
+        free(store->y);
+        free(store->width);
+        free(store->height);
+    }
+    free(store->active);
+    free(store->cells);
+    memset(store, 0, sizeof(*store));
+}
+
+bool initBrickCells(BrickStore *store, const uint8_t *startCells, int unbreakable) {
+    store->cells = malloc(store->capacity);
+    if (!store->cells) {
+        return false;
+    }
+    store->startCells = startCells;
+    store->unbreakable = unbreakable;
+    memcpy(store->cells, startCells, store->count);
+    return true;
+}
+
+void activateAllBricks(BrickStore *store) {
+    if (store->cells) {
+        memcpy(store->cells, store->startCells, store->count);
+    }
+    int fullWords = store->count / 64;
+    for (int w = 0; w < store->numWords; ++w) {
+        store->active[w] = w < fullWords ? ~(uint64_t)0 : 0;
+    }
+    if (store->count % 64) {
+        store->active[fullWords] = ~(uint64_t)0 >> (64 - store->count % 64);
+    }
+    store->liveCount = store->count;
+}
+
+// Rounding towards negative infinity, for boxes left of or above brick 0
+static inline int32_t floorDiv(int32_t a, int32_t b) {
+    return a / b - (a % b != 0 && a < 0);
+}
+
+// Lattice kernel: the bricks overlapping the box form a block of columns
+// and rows, found by division, so the cost depends on the box and not on
+// the level size
+static int overlapLattice(const BrickStore *store, int first, int32_t minX, int32_t minY,
+                          int32_t maxX, int32_t maxY, int *out, int maxOut) {
+    const BrickLattice *l = &store->lattice;
+    int rows = (store->count + l->cols - 1) / l->cols;
+    // Column c overlaps when originX + c * pitchX < maxX and its right edge
+    // is past minX; rows likewise
+    int col0 = floorDiv(minX - l->originX - l->width, l->pitchX) + 1;
+    int col1 = floorDiv(maxX - l->originX - 1, l->pitchX);
+    int row0 = floorDiv(minY - l->originY - l->height, l->pitchY) + 1;
+    int row1 = floorDiv(maxY - l->originY - 1, l->pitchY);
+    col0 = col0 > 0 ? col0 : 0;
+    col1 = col1 < l->cols - 1 ? col1 : l->cols - 1;
+    row0 = row0 > first / l->cols ? row0 : first / l->cols;
+    row1 = row1 < rows - 1 ? row1 : rows - 1;
+    int n = 0;
+    for (int row = row0; row <= row1; ++row) {
+        for (int col = col0; col <= col1; ++col) {
+            int i = row * l->cols + col;
+            if (i >= first && i < store->count && isBrickActive(store, i)) {
+                out[n++] = i;
+                if (n == maxOut) {
+                    return n;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+// Mask selecting the bits of word w at or after brick index first
+static inline uint64_t activeFrom(int w, int first) {
+    return w == first >> 6 ? ~(uint64_t)0 << (first & 63) : ~(uint64_t)0;
+}
+
+// Reference kernel: one brick at a time, visiting only active bits
+static int overlapScalar(const BrickStore *store, int first, int32_t minX, int32_t minY,
+                         int32_t maxX, int32_t maxY, int *out, int maxOut) {
+    int n = 0;
+    for (int w = first >> 6; w < store->numWords; ++w) {
+        uint64_t bits = store->active[w] & activeFrom(w, first);
+        while (bits) {
+            int i = w * 64 + countTrailingZeros64(bits);
+            bits &= bits - 1;
+            if (store->x[i] < maxX && store->x[i] + store->width[i] > minX &&
+                store->y[i] < maxY && store->y[i] + store->height[i] > minY) {
+                out[n++] = i;
+                if (n == maxOut) {
+                    return n;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+#ifdef BRICKS_X86_KERNELS
+
+// Four bricks per comparison
+__attribute__((target("sse2")))
+static int overlapSse2(const BrickStore *store, int first, int32_t minX, int32_t minY,
+                       int32_t maxX, int32_t maxY, int *out, int maxOut) {
+    const __m128i boxMinX = _mm_set1_epi32(minX), boxMaxX = _mm_set1_epi32(maxX);
+    const __m128i boxMinY = _mm_set1_epi32(minY), boxMaxY = _mm_set1_epi32(maxY);
+    int n = 0;
+    for (int w = first >> 6; w < store->numWords; ++w) {
+        uint64_t bits = store->active[w] & activeFrom(w, first);
+        if (!bits) {
+            continue;
+        }
+        for (int block = 0; block < 64; block += 4) {
+            unsigned blockBits = (unsigned)(bits >> block) & 0xF;
+            if (!blockBits) {
+                continue;
+            }
+            int i = w * 64 + block;
+            __m128i x = _mm_loadu_si128((const __m128i *)&store->x[i]);
+            __m128i y = _mm_loadu_si128((const __m128i *)&store->y[i]);
+            __m128i right = _mm_add_epi32(x, _mm_loadu_si128((const __m128i *)&store->width[i]));
+            __m128i bottom = _mm_add_epi32(y, _mm_loadu_si128((const __m128i *)&store->height[i]));
+            __m128i hit = _mm_and_si128(
+                _mm_and_si128(_mm_cmpgt_epi32(boxMaxX, x), _mm_cmpgt_epi32(right, boxMinX)),
+                _mm_and_si128(_mm_cmpgt_epi32(boxMaxY, y), _mm_cmpgt_epi32(bottom, boxMinY)));
+            unsigned mask = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(hit)) & blockBits;
+            while (mask) {
+                out[n++] = i + countTrailingZeros64(mask);
+                if (n == maxOut) {
+                    return n;
+                }
+                mask &= mask - 1;
+            }
+        }
+    }
+    return n;
+}
+
+// Eight bricks per comparison
+__attribute__((target("avx2")))
+static int overlapAvx2(const BrickStore *store, int first, int32_t minX, int32_t minY,
+                       int32_t maxX, int32_t maxY, int *out, int maxOut) {
+    const __m256i boxMinX = _mm256_set1_epi32(minX), boxMaxX = _mm256_set1_epi32(maxX);
+    const __m256i boxMinY = _mm256_set1_epi32(minY), boxMaxY = _mm256_set1_epi32(maxY);
+    int n = 0;
+    for (int w = first >> 6; w < store->numWords; ++w) {
+        uint64_t bits = store->active[w] & activeFrom(w, first);
+        if (!bits) {
+            continue;
+        }
+        for (int block = 0; block < 64; block += 8) {
+            unsigned blockBits = (unsigned)(bits >> block) & 0xFF;
+            if (!blockBits) {
+                continue;
+            }
+            int i = w * 64 + block;
+            __m256i x = _mm256_loadu_si256((const __m256i *)&store->x[i]);
+            __m256i y = _mm256_loadu_si256((const __m256i *)&store->y[i]);
+            __m256i right = _mm256_add_epi32(x, _mm256_loadu_si256((const __m256i *)&store->width[i]));
+            __m256i bottom = _mm256_add_epi32(y, _mm256_loadu_si256((const __m256i *)&store->height[i]));
+            __m256i hit = _mm256_and_si256(
+                _mm256_and_si256(_mm256_cmpgt_epi32(boxMaxX, x), _mm256_cmpgt_epi32(right, boxMinX)),
+                _mm256_and_si256(_mm256_cmpgt_epi32(boxMaxY, y), _mm256_cmpgt_epi32(bottom, boxMinY)));
+            unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(hit)) & blockBits;
+            while (mask) {
+                out[n++] = i + countTrailingZeros64(mask);
+                if (n == maxOut) {
+                    return n;
+                }
+                mask &= mask - 1;
+            }
+        }
+    }
+    return n;
+}
+
+#endif
+
+// Force a particular kernel ("avx2", "sse2", "scalar"); NULL picks the
+// best one the CPU supports. Returns false if the kernel is unavailable.
+bool selectBrickKernel(const char *name) {
+#ifdef BRICKS_X86_KERNELS
+    __builtin_cpu_init();
+    bool hasAvx2 = __builtin_cpu_supports("avx2");
+    bool hasSse2 = __builtin_cpu_supports("sse2");
+    if ((!name && hasAvx2) || (name && strcmp(name, "avx2") == 0)) {
+        if (!hasAvx2) {
+            return false;
+        }
+        overlapKernel = overlapAvx2;
+        overlapKernelName = "avx2";
+        return true;
+    }
+    if ((!name && hasSse2) || (name && strcmp(name, "sse2") == 0)) {
+        if (!hasSse2) {
+            return false;
+        }
+        overlapKernel = overlapSse2;
+        overlapKernelName = "sse2";
+        return true;
+    }
+#endif
+    if (!name || strcmp(name, "scalar") == 0) {
+        overlapKernel = overlapScalar;
+        overlapKernelName = "scalar";
+        return true;
+    }
+    return false;
+}
+
+const char *brickKernelName(void) {
+    return overlapKernelName;
+}
+
+// Collect the indices of active bricks overlapping the box
+int findOverlappingBricks(const BrickStore *store, int first,
+                          float minX, float minY, float maxX, float maxY,
+                          int *out, int maxOut) {
+    if (!overlapKernel) {
+        selectBrickKernel(NULL);
+    }
+    // Bricks sit on integer coordinates, so x < maxX is x < ceil(maxX) and
+    // x + width > minX is x + width > floor(minX); compare as integers
+    if (first < 0 || first >= store->count) {
+        return 0;
+    }
+    BrickOverlapKernel kernel = store->lattice.cols ? overlapLattice : overlapKernel;
+    return kernel(store, first, (int32_t)floorf(minX), (int32_t)floorf(minY),
+                  (int32_t)ceilf(maxX), (int32_t)ceilf(maxY), out, maxOut);
+}
@@ -0,0 +1,166 @@
+#ifndef BRICKS_H
+#define BRICKS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Bricks are stored as parallel arrays so the overlap kernel can load
+// several bricks' coordinates per instruction. Arrays are padded to a
+// multiple of BRICK_BLOCK entries; padding bricks are never active.
+#define BRICK_BLOCK 8
+
+// Brick types. Hard bricks differ from normal ones only in taking more
+// hits; unbreakable ones are never destroyed.
+enum {
+    BRICK_NORMAL,
+    BRICK_HARD,
+    BRICK_UNBREAKABLE
+};
+
+// A brick's type and the hits it still takes, packed in one byte: the type
+// in the top two bits, the hits below
+#define MAX_BRICK_HITS 63
+
+static inline uint8_t brickCell(int type, int hits) {
+    return (uint8_t)(type << 6 | hits);
+}
+
+static inline int cellType(uint8_t cell) {
+    return cell >> 6;
+}
+
+static inline int cellHits(uint8_t cell) {
+    return cell & MAX_BRICK_HITS;
+}
+
+// Bricks on a regular lattice: brick i sits in column i % cols and row
+// i / cols, so its geometry follows from its index and only the active
+// mask is stored, one bit per brick. A million bricks take 128 KB.
+typedef struct {
+    int cols;                  // 0: the store has explicit geometry arrays
+    int32_t originX, originY;  // Top-left corner of brick 0
+    int32_t pitchX, pitchY;    // Distance between neighbouring bricks
+    int32_t width, height;     // Size of every brick, at most the pitch
+} BrickLattice;
+
+typedef struct BrickStore {
+    int32_t *x, *y;    // NULL for a lattice
+    int32_t *width, *height;
+    uint64_t *active;  // One bit per brick
+    int liveCount;     // Number of set bits in active
+    int count;
+    int capacity;      // count rounded up to BRICK_BLOCK
+    int numWords;      // Length of active in 64-bit words
+
+    // Per-brick data of a level file, NULL for the built-in level. cells
+    // are the game's own copy of startCells (brickCell bytes), reset with
+    // the bricks; both are NULL when every brick breaks on its first hit.
+    uint8_t *cells;
+    const uint8_t *startCells;
+    int unbreakable;         // Bricks that never break; standing, but not needed to win
+    const uint32_t *colors;  // 0xRRGGBBAA
+    bool borrowed;           // x, y, width and height belong to a level file
+    BrickLattice lattice;
+} BrickStore;
+
+bool initBrickStore(BrickStore *store, int count);
+
+// Use geometry arrays owned elsewhere (a mapped level file) in place; they
+// must hold count entries padded with zeros to a multiple of BRICK_BLOCK.
+// Only the active mask is allocated, with every brick standing.
+bool initBrickStoreView(BrickStore *store, int count, const int32_t *x, const int32_t *y,
+                        const int32_t *width, const int32_t *height);
+
+// Bricks on a lattice, every one standing; only the active mask is
+// allocated. false if the lattice is invalid or memory runs out.
+bool initBrickLattice(BrickStore *store, int count, const BrickLattice *lattice);
+void freeBrickStore(BrickStore *store);
+
+// Give the bricks per-brick types and hits (count brickCell bytes owned
+// elsewhere, unbreakable of them of that type); false if memory runs out
+bool initBrickCells(BrickStore *store, const uint8_t *startCells, int unbreakable);
+
+// Mark every brick as standing with its starting hits
+void activateAllBricks(BrickStore *store);
+
+// Geometry of brick i, for either kind of store
+static inline int32_t brickX(const BrickStore *store, int i) {
+    const BrickLattice *l = &store->lattice;
+    return l->cols ? l->originX + i % l->cols * l->pitchX : store->x[i];
+}
+
+static inline int32_t brickY(const BrickStore *store, int i) {
+    const BrickLattice *l = &store->lattice;
+    return l->cols ? l->originY + i / l->cols * l->pitchY : store->y[i];
+}
+
+static inline int32_t brickWidth(const BrickStore *store, int i) {
+    return store->lattice.cols ? store->lattice.width : store->width[i];
+}
+
+static inline int32_t brickHeight(const BrickStore *store, int i) {
+    return store->lattice.cols ? store->lattice.height : store->height[i];
+}
+
+static inline bool isBrickActive(const BrickStore *store, int i) {
+    return (store->active[i >> 6] >> (i & 63)) & 1;
+}
+
+static inline void setBrickActive(BrickStore *store, int i, bool active) {
+    uint64_t bit = (uint64_t)1 << (i & 63);
+    uint64_t *word = &store->active[i >> 6];
+    if (active && !(*word & bit)) {
+        *word |= bit;
+        store->liveCount++;
+    } else if (!active && (*word & bit)) {
+        *word &= ~bit;
+        store->liveCount--;
+    }
+}
+
+static inline int countTrailingZeros64(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int n = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+// Index of the first active brick at or after from, or -1. Dead bricks
+// are skipped 64 at a time, so a loop of
+//     for (i = nextActiveBrick(s, 0); i >= 0; i = nextActiveBrick(s, i + 1))
+// costs O(live bricks + words) rather than O(all bricks).
+static inline int nextActiveBrick(const BrickStore *store, int from) {
+    int w = from >> 6;
+    if (w >= store->numWords) {
+        return -1;
+    }
+    uint64_t bits = store->active[w] & (~(uint64_t)0 << (from & 63));
+    while (!bits) {
+        if (++w == store->numWords) {
+            return -1;
+        }
+        bits = store->active[w];
+    }
+    return w * 64 + countTrailingZeros64(bits);
+}
+
+// Collect the indices (from first onwards) of active bricks overlapping the
+// box [minX, maxX) x [minY, maxY) into out, at most maxOut; returns the
+// count. When out fills up, call again with first = out[maxOut - 1] + 1.
+// Uses the widest kernel the CPU supports (AVX2, SSE2 or scalar); on a
+// lattice only the bricks under the box are visited.
+int findOverlappingBricks(const BrickStore *store, int first,
+                          float minX, float minY, float maxX, float maxY,
+                          int *out, int maxOut);
+
+// Force a particular kernel ("avx2", "sse2", "scalar"); false if unsupported
+bool selectBrickKernel(const char *name);
+const char *brickKernelName(void);
+
+#endif
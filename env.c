@@ -0,0 +1,202 @@
+#include "env.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+
+// Games handed to a worker at a time
+static const int ENVS_PER_TASK = 64;
+
+struct EnvBatch {
+    EnvSettings settings;
+    int obsSize;
+    ThreadPool *pool;
+
+    // Brick geometry shared by every game; its mask is the starting level
+    BrickStore layout;
+
+    // Per-game pools, indexed by game. Each game's BrickStore points at the
+    // shared geometry and at its own numWords words of masks.
+    GameState *games;
+    Ball *balls;
+    BallHits *ballHits;
+    uint64_t *masks;
+    int *steps;        // Actions taken in the current game
+    bool *finished;    // Reported done; restarted by the next step
+};
+
+// Put a game in its starting position without touching the shared layout
+static void startGame(EnvBatch *batch, int e) {
+    GameState *game = &batch->games[e];
+    memcpy(game->bricks.active, batch->layout.active, sizeof(uint64_t) * batch->layout.numWords);
+    game->bricks.liveCount = batch->layout.liveCount;
+    game->score = 0;
+    game->gameOver = false;
+    game->playerWon = false;
+    game->rng = game->seed;
+    initPaddle(&game->paddle);
+    game->numBalls = 1;
+    initBall(&game->balls[0]);
+    game->ballHits[0].count = 0;
+    game->ballHits[0].lost = false;
+    clearBrickEvents(game);
+    batch->steps[e] = 0;
+    batch->finished[e] = false;
+}
+
+static void writeObservation(const EnvBatch *batch, int e, float *row) {
+    const GameState *game = &batch->games[e];
+    row[ENV_OBS_PADDLE_X] = game->paddle.x / SCREEN_WIDTH;
+    if (game->numBalls > 0) {
+        const Ball *ball = &game->balls[0];
+        row[ENV_OBS_BALL_X] = ball->x / SCREEN_WIDTH;
+        row[ENV_OBS_BALL_Y] = ball->y / SCREEN_HEIGHT;
+        row[ENV_OBS_BALL_DX] = ball->dx / BALL_SPEED;
+        row[ENV_OBS_BALL_DY] = ball->dy / BALL_SPEED;
+    } else {
+        row[ENV_OBS_BALL_X] = row[ENV_OBS_BALL_Y] = 0.f;
+        row[ENV_OBS_BALL_DX] = row[ENV_OBS_BALL_DY] = 0.f;
+    }
+    float *bricks = &row[ENV_OBS_BRICKS];
+    for (int i = 0; i < game->bricks.count; ++i) {
+        bricks[i] = (float)((game->bricks.active[i >> 6] >> (i & 63)) & 1);
+    }
+}
+
+EnvBatch *createEnvBatch(const EnvSettings *settings) {
+    if (settings->count < 1 || settings->numBricks < 1) {
+        printf("An environment batch needs at least one game and one brick!\n");
+        return NULL;
+    }
+    EnvBatch *batch = calloc(1, sizeof(EnvBatch));
+    if (!batch) {
+        printf("Failed to allocate environments!\n");
+        return NULL;
+    }
+    batch->settings = *settings;
+    if (batch->settings.dt <= 0) {
+        batch->settings.dt = 1.f / PHYSICS_HZ;
+    }
+    if (batch->settings.actionRepeat < 1) {
+        batch->settings.actionRepeat = 1;
+    }
+    batch->obsSize = ENV_OBS_BRICKS + settings->numBricks;
+
+    int count = settings->count;
+    if (!initBuiltInBricks(&batch->layout, settings->numBricks)) {
+        free(batch);
+        printf("Failed to allocate environments!\n");
+        return NULL;
+    }
+    int numWords = batch->layout.numWords;
+    batch->games = calloc(count, sizeof(GameState));
+    batch->balls = calloc(count, sizeof(Ball));
+    batch->ballHits = calloc(count, sizeof(BallHits));
+    batch->masks = calloc((size_t)count * numWords, sizeof(uint64_t));
+    batch->steps = calloc(count, sizeof(int));
+    batch->finished = calloc(count, sizeof(bool));
+    batch->pool = createThreadPool(settings->numThreads);
+    if (!batch->games || !batch->balls || !batch->ballHits || !batch->masks ||
+        !batch->steps || !batch->finished || !batch->pool) {
+        destroyEnvBatch(batch);
+        printf("Failed to allocate environments!\n");
+        return NULL;
+    }
+
+    for (int e = 0; e < count; ++e) {
+        GameState *game = &batch->games[e];
+        game->bricks = batch->layout;
+        game->bricks.active = &batch->masks[(size_t)e * numWords];
+        game->balls = &batch->balls[e];
+        game->ballHits = &batch->ballHits[e];
+        game->ballCapacity = 1;  // No power-ups, so never more than one ball
+        // The lattice needs no per-game index (a grid per game would
+        // multiply the index memory by the batch size), and it visits only
+        // the bricks under the ball, where the SIMD brute-force kernel
+        // would scan them all
+        game->collisionMode = COLLIDE_LATTICE;
+        game->seed = (uint32_t)e + 1;
+        startGame(batch, e);
+    }
+    return batch;
+}
+
+void destroyEnvBatch(EnvBatch *batch) {
+    if (!batch) {
+        return;
+    }
+    destroyThreadPool(batch->pool);
+    freeBrickStore(&batch->layout);
+    free(batch->games);
+    free(batch->balls);
+    free(batch->ballHits);
+    free(batch->masks);
+    free(batch->steps);
+    free(batch->finished);
+    free(batch);
+}
+
+int envCount(const EnvBatch *batch) {
+    return batch->settings.count;
+}
+
+int envObservationSize(const EnvBatch *batch) {
+    return batch->obsSize;
+}
+
+void resetEnvs(EnvBatch *batch, float *observations) {
+    for (int e = 0; e < batch->settings.count; ++e) {
+        startGame(batch, e);
+        writeObservation(batch, e, &observations[(size_t)e * batch->obsSize]);
+    }
+}
+
+typedef struct {
+    EnvBatch *batch;
+    const float *actions;
+    float *observations;
+    float *rewards;
+    uint8_t *dones;
+} EnvStepTask;
+
+// Step games [begin, end); each touches only its own slots of every pool
+static void stepEnvRange(void *context, int begin, int end, int worker) {
+    const EnvStepTask *task = context;
+    EnvBatch *batch = task->batch;
+    const EnvSettings *settings = &batch->settings;
+    (void)worker;
+    for (int e = begin; e < end; ++e) {
+        GameState *game = &batch->games[e];
+        float reward = 0.f;
+        if (batch->finished[e]) {
+            startGame(batch, e);
+        } else {
+            float action = fminf(fmaxf(task->actions[e], -1.f), 1.f);
+            GameInput input = { action * PADDLE_VELOCITY * settings->dt };
+            int score = game->score;
+            for (int r = 0; r < settings->actionRepeat && !game->gameOver; ++r) {
+                stepGame(game, &input, settings->dt);
+            }
+            clearBrickEvents(game);
+            reward = (float)(game->score - score);
+            if (game->gameOver && !game->playerWon) {
+                reward -= 1.f;
+            }
+            batch->steps[e]++;
+            batch->finished[e] = game->gameOver ||
+                                 (settings->maxSteps > 0 && batch->steps[e] >= settings->maxSteps);
+        }
+        task->rewards[e] = reward;
+        task->dones[e] = batch->finished[e];
+        writeObservation(batch, e, &task->observations[(size_t)e * batch->obsSize]);
+    }
+}
+
+void stepEnvs(EnvBatch *batch, const float *actions, float *observations, float *rewards, uint8_t *dones) {
+    EnvStepTask task = { batch, actions, observations, rewards, dones };
+    parallelFor(batch->pool, batch->settings.count, ENVS_PER_TASK, stepEnvRange, &task);
+}
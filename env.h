@@ -0,0 +1,56 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include <stdint.h>
+
+// A batch of independent games for training paddle-control agents. Every
+// game runs the same stepGame rules as the window, one ball and no
+// power-ups, and the whole batch is stepped at once across a thread pool.
+// The games live in contiguous pools: game states, balls and hit lists
+// are arrays indexed by game, every game's active-brick mask sits in one
+// shared bit array and the brick geometry is stored once for all of them.
+// Collisions are looked up on the built-in brick lattice; games are not
+// vectorized against each other.
+typedef struct EnvBatch EnvBatch;
+
+typedef struct {
+    int count;         // Games in the batch
+    int numBricks;     // Bricks per level (NUM_BRICKS for the normal level)
+    float dt;          // Physics step in seconds (0: 1 / PHYSICS_HZ)
+    int actionRepeat;  // Physics steps per action (at least 1)
+    int maxSteps;      // Actions before a game is cut off (0: no limit)
+    int numThreads;    // 0: one per hardware thread
+} EnvSettings;
+
+// Observation of one game, followed by one value per brick (1 = standing)
+enum {
+    ENV_OBS_PADDLE_X,  // Left edge / SCREEN_WIDTH
+    ENV_OBS_BALL_X,    // Ball position / screen size (0 once the ball is lost)
+    ENV_OBS_BALL_Y,
+    ENV_OBS_BALL_DX,   // Ball velocity / BALL_SPEED
+    ENV_OBS_BALL_DY,
+    ENV_OBS_BRICKS
+};
+
+// NULL (with a message) on failure
+EnvBatch *createEnvBatch(const EnvSettings *settings);
+void destroyEnvBatch(EnvBatch *batch);
+
+int envCount(const EnvBatch *batch);
+
+// Floats per game in the observation arrays: ENV_OBS_BRICKS + numBricks
+int envObservationSize(const EnvBatch *batch);
+
+// Restart every game and write the first observations, count rows of
+// envObservationSize floats
+void resetEnvs(EnvBatch *batch, float *observations);
+
+// Move every paddle by its action (-1 full speed left .. 1 full speed
+// right) and advance actionRepeat physics steps. Writes each game's
+// observation, reward (bricks destroyed, minus 1 for losing the ball) and
+// done flag (game over or maxSteps reached). A game that reported done is
+// restarted by the next call, which ignores its action and returns its
+// first observation with reward 0.
+void stepEnvs(EnvBatch *batch, const float *actions, float *observations, float *rewards, uint8_t *dones);
+
+#endif
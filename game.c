@@ -0,0 +1,748 @@
+#include "game.h"
+#include "profiler.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Initialize game elements
+void initPaddle(Paddle *paddle) {
+    paddle->width = PADDLE_WIDTH;
+    paddle->height = PADDLE_HEIGHT;
+    paddle->x = (SCREEN_WIDTH - PADDLE_WIDTH) / 2;
+    paddle->y = SCREEN_HEIGHT - PADDLE_HEIGHT - 10;
+    paddle->prevX = paddle->x;
+    paddle->prevY = paddle->y;
+}
+
+void initBall(Ball *ball) {
+    ball->size = BALL_SIZE;
+    ball->x = SCREEN_WIDTH / 2;
+    ball->y = SCREEN_HEIGHT - PADDLE_HEIGHT - BALL_SIZE - 20;
+    ball->dx = BALL_SPEED; // Horizontal speed
+    ball->dy = -BALL_SPEED; // Vertical speed
+    ball->prevX = ball->x;
+    ball->prevY = ball->y;
+}
+
+// Rows of ten bricks, 5 pixels apart
+static const BrickLattice BUILT_IN_LATTICE = {
+    10, 15, 15, BRICK_WIDTH + 5, BRICK_HEIGHT + 5, BRICK_WIDTH, BRICK_HEIGHT
+};
+
+bool initBuiltInBricks(BrickStore *bricks, int numBricks) {
+    return initBrickLattice(bricks, numBricks, &BUILT_IN_LATTICE);
+}
+
+void initBricks(BrickStore *bricks) {
+    BrickStore lattice = { .lattice = BUILT_IN_LATTICE };
+    for (int i = 0; i < bricks->count; ++i) {
+        bricks->width[i] = brickWidth(&lattice, i);
+        bricks->height[i] = brickHeight(&lattice, i);
+        bricks->x[i] = brickX(&lattice, i);
+        bricks->y[i] = brickY(&lattice, i);
+        setBrickActive(bricks, i, true);
+    }
+}
+
+// Function to check collision between ball and brick
+bool checkCollision(const Ball *ball, const BrickStore *bricks, int i) {
+    int32_t x = brickX(bricks, i), y = brickY(bricks, i);
+    if (ball->x + ball->size > x &&
+        ball->x < x + brickWidth(bricks, i) &&
+        ball->y + ball->size > y &&
+        ball->y < y + brickHeight(bricks, i)) {
+        return true;
+    }
+    return false;
+}
+
+// O(1): the store keeps a live-brick count as bricks are deactivated.
+// Unbreakable bricks stay standing and do not count.
+bool areAllBricksDestroyed(const GameState *state) {
+    return state->bricks.liveCount == state->bricks.unbreakable;
+}
+
+// Contacts closer together than this (in seconds) count as simultaneous
+static const float CONTACT_EPSILON = 1e-5f;
+
+// Padding of the brick query box in pixels, well above float rounding at
+// screen coordinates
+static const float QUERY_MARGIN = 0.5f;
+
+// Upper bound on contacts resolved for one ball in one step
+static const int MAX_BOUNCES_PER_STEP = 16;
+
+// Bricks that can be destroyed by one contact (e.g. a shared edge)
+#define MAX_SIMULTANEOUS_HITS 8
+
+// Swept boxes covering more grid cells than this walk the path instead
+static const int MAX_BOX_CELLS = 12;
+
+// Time of impact of the ball against the box within maxTime seconds.
+// The ball is swept as a point (its top-left corner) against the box grown
+// by the ball size. Boxes the ball already overlaps by more than
+// CONTACT_EPSILON are ignored, so a ball resting on a surface it has just
+// bounced off does not hit it again.
+bool sweepBall(const Ball *ball, float minX, float minY, float maxX, float maxY,
+               float maxTime, Contact *contact) {
+    float enterX, exitX, enterY, exitY;
+    minX -= ball->size;
+    minY -= ball->size;
+
+    if (ball->dx != 0) {
+        float t0 = (minX - ball->x) / ball->dx;
+        float t1 = (maxX - ball->x) / ball->dx;
+        enterX = fminf(t0, t1);
+        exitX = fmaxf(t0, t1);
+    } else if (ball->x > minX && ball->x < maxX) {
+        enterX = -INFINITY;
+        exitX = INFINITY;
+    } else {
+        return false;
+    }
+    if (ball->dy != 0) {
+        float t0 = (minY - ball->y) / ball->dy;
+        float t1 = (maxY - ball->y) / ball->dy;
+        enterY = fminf(t0, t1);
+        exitY = fmaxf(t0, t1);
+    } else if (ball->y > minY && ball->y < maxY) {
+        enterY = -INFINITY;
+        exitY = INFINITY;
+    } else {
+        return false;
+    }
+
+    float enter = fmaxf(enterX, enterY);
+    float exit = fminf(exitX, exitY);
+    if (enter >= exit || enter < -CONTACT_EPSILON || enter > maxTime) {
+        return false;
+    }
+
+    // The face crossed last is the one the ball hits
+    contact->time = fmaxf(enter, 0.f);
+    if (enterX > enterY) {
+        contact->nx = ball->dx > 0 ? -1.f : 1.f;
+        contact->ny = 0.f;
+    } else {
+        contact->nx = 0.f;
+        contact->ny = ball->dy > 0 ? -1.f : 1.f;
+    }
+    return true;
+}
+
+// Keep the earlier of two contacts; merge normals of simultaneous ones
+static bool mergeContact(Contact *best, const Contact *candidate) {
+    if (candidate->time < best->time - CONTACT_EPSILON) {
+        *best = *candidate;
+        return true;
+    }
+    if (candidate->time <= best->time + CONTACT_EPSILON) {
+        if (candidate->nx != 0) {
+            best->nx = candidate->nx;
+        }
+        if (candidate->ny != 0) {
+            best->ny = candidate->ny;
+        }
+        best->time = fminf(best->time, candidate->time);
+        return true;
+    }
+    return false;
+}
+
+// Bounce off a surface: each axis is reflected at most once, and only if
+// the ball is moving into the surface
+static void reflectBall(Ball *ball, float nx, float ny) {
+    if (nx != 0) {
+        ball->dx = nx > 0 ? fabsf(ball->dx) : -fabsf(ball->dx);
+    }
+    if (ny != 0) {
+        ball->dy = ny > 0 ? fabsf(ball->dy) : -fabsf(ball->dy);
+    }
+}
+
+static void advanceBall(Ball *ball, float time) {
+    ball->x += ball->dx * time;
+    ball->y += ball->dy * time;
+}
+
+// Deactivate a brick during the merge phase
+static void destroyBrick(GameState *state, int i) {
+    setBrickActive(&state->bricks, i, false);  // Deactivate the brick
+    if (state->collisionMode == COLLIDE_GRID) {
+        removeBrickFromGrid(&state->grid, &state->bricks, i);
+    }
+    state->score++;                            // Increase score
+
+    BrickEvents *events = &state->brickEvents;
+    if (events->count < MAX_BRICK_EVENTS) {
+        events->destroyed[events->count++] = i;
+    } else {
+        events->rebuild = true;
+    }
+}
+
+// Take a hit off a brick during the merge phase; it is destroyed by its
+// last one. Unbreakable bricks only turn balls. True if it was destroyed.
+static bool hitBrick(GameState *state, int i) {
+    uint8_t *cells = state->bricks.cells;
+    if (cells) {
+        if (cellType(cells[i]) == BRICK_UNBREAKABLE) {
+            return false;
+        }
+        cells[i]--;  // Hits are the low bits
+        if (cellHits(cells[i]) > 0) {
+            BrickDamage *damage = &state->damage;
+            if (damage->count < MAX_BRICK_EVENTS) {
+                damage->bricks[damage->count++] = i;
+            } else {
+                damage->overflow = true;
+            }
+            return false;
+        }
+    }
+    destroyBrick(state, i);
+    return true;
+}
+
+static void clearBrickDamage(GameState *state) {
+    state->damage.count = 0;
+    state->damage.overflow = false;
+}
+
+// Track the earliest brick contact(s) seen so far
+typedef struct {
+    Contact contact;
+    int bricks[MAX_SIMULTANEOUS_HITS];
+    int numBricks;
+    const BallHits *ballHits;  // Bricks this ball already hit this step
+} BrickHits;
+
+// A ball only sees the bricks as they were at the start of the step, so it
+// must skip the ones it has already hit itself during this step
+static bool alreadyHit(const BallHits *ballHits, int i) {
+    for (int h = 0; h < ballHits->count; ++h) {
+        if (ballHits->bricks[h] == i) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void sweepBrick(const GameState *state, const Ball *ball, int i, BrickHits *hits) {
+    const BrickStore *bricks = &state->bricks;
+    Contact contact;
+    if (hits->ballHits->count > 0 && alreadyHit(hits->ballHits, i)) {
+        return;
+    }
+    int32_t x = brickX(bricks, i), y = brickY(bricks, i);
+    if (!sweepBall(ball, x, y, x + brickWidth(bricks, i), y + brickHeight(bricks, i),
+                   hits->contact.time + CONTACT_EPSILON, &contact)) {
+        return;
+    }
+    bool earlier = contact.time < hits->contact.time - CONTACT_EPSILON;
+    if (mergeContact(&hits->contact, &contact)) {
+        if (earlier) {
+            hits->numBricks = 0;
+        }
+        if (hits->numBricks < MAX_SIMULTANEOUS_HITS) {
+            hits->bricks[hits->numBricks++] = i;
+        }
+    }
+}
+
+// Narrow [t0, t1] to the times at which p + v * t lies in [low, high]
+static bool clipToRange(float p, float v, float low, float high, float *t0, float *t1) {
+    if (v == 0) {
+        return p >= low && p <= high;
+    }
+    float ta = (low - p) / v, tb = (high - p) / v;
+    *t0 = fmaxf(*t0, fminf(ta, tb));
+    *t1 = fminf(*t1, fmaxf(ta, tb));
+    return *t0 <= *t1;
+}
+
+// Walk the grid cells under the ball's path in order of time (a DDA, as
+// for ray casting) and stop at the first cell that ends after the earliest
+// contact found. Used for long paths, where the swept box would cover
+// most of the grid. A brick's grown box reaches at most one cell beyond
+// its home cell in any direction, so each visited cell checks its 3x3
+// neighbourhood.
+static void sweepBricksAlongPath(const GameState *state, const Ball *ball, BrickHits *hits) {
+    const BrickGrid *grid = &state->grid;
+    float cw = grid->cellWidth, ch = grid->cellHeight;
+
+    // Clip the path to the grid padded by one cell
+    float tStart = 0.f, tEnd = hits->contact.time;
+    if (!clipToRange(ball->x, ball->dx, grid->originX - cw, grid->originX + (grid->cols + 1) * cw, &tStart, &tEnd) ||
+        !clipToRange(ball->y, ball->dy, grid->originY - ch, grid->originY + (grid->rows + 1) * ch, &tStart, &tEnd)) {
+        return;
+    }
+
+    int col = (int)floorf((ball->x + ball->dx * tStart - grid->originX) / cw);
+    int row = (int)floorf((ball->y + ball->dy * tStart - grid->originY) / ch);
+    int stepCol = ball->dx > 0 ? 1 : -1;
+    int stepRow = ball->dy > 0 ? 1 : -1;
+    float tDeltaX = ball->dx != 0 ? cw / fabsf(ball->dx) : INFINITY;
+    float tDeltaY = ball->dy != 0 ? ch / fabsf(ball->dy) : INFINITY;
+    float tMaxX = ball->dx != 0 ? (grid->originX + (col + (ball->dx > 0)) * cw - ball->x) / ball->dx : INFINITY;
+    float tMaxY = ball->dy != 0 ? (grid->originY + (row + (ball->dy > 0)) * ch - ball->y) / ball->dy : INFINITY;
+
+    for (;;) {
+        for (int r = row - 1; r <= row + 1; ++r) {
+            for (int c = col - 1; c <= col + 1; ++c) {
+                if (r < 0 || r >= grid->rows || c < 0 || c >= grid->cols) {
+                    continue;
+                }
+                int cell = r * grid->cols + c;
+                const int *slots = &grid->cellBricks[grid->cellStart[cell]];
+                for (int s = 0; s < grid->cellCount[cell]; ++s) {
+                    sweepBrick(state, ball, slots[s], hits);
+                }
+            }
+        }
+
+        float tCellExit = fminf(tMaxX, tMaxY);
+        if ((hits->numBricks > 0 && hits->contact.time <= tCellExit) || tCellExit > tEnd) {
+            return;
+        }
+        if (tMaxX < tMaxY) {
+            col += stepCol;
+            tMaxX += tDeltaX;
+        } else {
+            row += stepRow;
+            tMaxY += tDeltaY;
+        }
+    }
+}
+
+// Function to handle ball-brick collisions. Sweeps the ball against the
+// bricks for up to maxTime seconds; on a hit the ball is moved to the
+// contact, every brick touched at that instant is recorded in the ball's
+// hit list (destroyed when hits are merged), the ball is reflected once
+// and the time used is returned. Returns -1 (ball untouched) when no brick
+// is reached in time. Only reads the game state, so balls can be handled
+// in parallel.
+//
+// Candidates come from the uniform grid cells under the swept box, so the
+// cost does not grow with the brick count; long paths walk the grid cell
+// by cell instead. Small levels are scanned whole with the SIMD overlap
+// kernel, and on a lattice the bricks under the box are looked up directly.
+float handleBallBrickCollisions(const GameState *state, Ball *ball, float maxTime, BallHits *ballHits) {
+    float endX = ball->x + ball->dx * maxTime;
+    float endY = ball->y + ball->dy * maxTime;
+    // Pad the swept box so bricks the ball is just touching are candidates
+    float minX = fminf(ball->x, endX) - QUERY_MARGIN, maxX = fmaxf(ball->x, endX) + ball->size + QUERY_MARGIN;
+    float minY = fminf(ball->y, endY) - QUERY_MARGIN, maxY = fmaxf(ball->y, endY) + ball->size + QUERY_MARGIN;
+
+    BrickHits hits;
+    hits.contact = (Contact){ maxTime, 0.f, 0.f };
+    hits.numBricks = 0;
+    hits.ballHits = ballHits;
+
+    if (state->collisionMode != COLLIDE_GRID) {
+        int candidates[64];
+        int numCandidates;
+        int first = 0;
+        do {
+            numCandidates = findOverlappingBricks(&state->bricks, first, minX, minY, maxX, maxY,
+                                                  candidates, 64);
+            for (int c = 0; c < numCandidates; ++c) {
+                sweepBrick(state, ball, candidates[c], &hits);
+            }
+            if (numCandidates > 0) {
+                first = candidates[numCandidates - 1] + 1;
+            }
+        } while (numCandidates == 64);
+    } else {
+        const BrickGrid *grid = &state->grid;
+        int col0, row0, col1, row1;
+        brickGridRange(grid, minX, minY, maxX, maxY, &col0, &row0, &col1, &row1);
+        if ((col1 - col0 + 1) * (row1 - row0 + 1) > MAX_BOX_CELLS) {
+            sweepBricksAlongPath(state, ball, &hits);
+        } else {
+            for (int row = row0; row <= row1; ++row) {
+                for (int col = col0; col <= col1; ++col) {
+                    int cell = row * grid->cols + col;
+                    const int *slots = &grid->cellBricks[grid->cellStart[cell]];
+                    for (int s = 0; s < grid->cellCount[cell]; ++s) {
+                        sweepBrick(state, ball, slots[s], &hits);
+                    }
+                }
+            }
+        }
+    }
+
+    if (hits.numBricks == 0) {
+        return -1.f;
+    }
+    advanceBall(ball, hits.contact.time);
+    for (int h = 0; h < hits.numBricks && ballHits->count < MAX_BALL_HITS; ++h) {
+        ballHits->bricks[ballHits->count++] = hits.bricks[h];
+    }
+    reflectBall(ball, hits.contact.nx, hits.contact.ny);  // Change the ball's direction
+    return hits.contact.time;
+}
+
+// Move the ball for up to duration seconds, stopping at every wall, paddle
+// and brick contact on the way to reflect it, so no speed or step length
+// can make it pass through anything. Stops early after maxContacts
+// contacts or on reaching the floor; returns the time that passed. Bricks
+// hit and floor contact are reported in hits.
+static float moveBall(const GameState *state, Ball *ball, BallHits *hits, float duration, int maxContacts) {
+    const Paddle *paddle = &state->paddle;
+
+    // The paddle moves in jumps and may have been pushed into the ball
+    if (ball->dy > 0 &&
+        ball->y + ball->size > paddle->y && ball->y < paddle->y + paddle->height &&
+        ball->x + ball->size > paddle->x && ball->x < paddle->x + paddle->width) {
+        ball->dy = -ball->dy;
+    }
+
+    // Always look once, so a contact due right now is resolved even when
+    // duration is zero
+    float elapsed = 0.f;
+    for (int bounce = 0; bounce < maxContacts && (elapsed < duration || bounce == 0); ++bounce) {
+        Contact contact = { duration - elapsed, 0.f, 0.f };
+        Contact candidate;
+
+        // Collision with walls
+        if (ball->dx < 0) {
+            candidate = (Contact){ fmaxf(-ball->x / ball->dx, 0.f), 1.f, 0.f };
+            mergeContact(&contact, &candidate);
+        } else if (ball->dx > 0) {
+            candidate = (Contact){ fmaxf((SCREEN_WIDTH - ball->size - ball->x) / ball->dx, 0.f), -1.f, 0.f };
+            mergeContact(&contact, &candidate);
+        }
+        if (ball->dy < 0) {
+            candidate = (Contact){ fmaxf(-ball->y / ball->dy, 0.f), 0.f, 1.f };
+            mergeContact(&contact, &candidate);
+        }
+
+        // Collision with paddle
+        if (sweepBall(ball, paddle->x, paddle->y, paddle->x + paddle->width, paddle->y + paddle->height,
+                      contact.time, &candidate)) {
+            mergeContact(&contact, &candidate);
+        }
+
+        // Reaching the bottom of the screen loses the ball
+        bool reachesFloor = false;
+        if (ball->dy > 0) {
+            float floorTime = fmaxf((SCREEN_HEIGHT - ball->size - ball->y) / ball->dy, 0.f);
+            if (state->solidFloor) {
+                candidate = (Contact){ floorTime, 0.f, -1.f };
+                mergeContact(&contact, &candidate);
+            } else if (floorTime <= contact.time) {
+                contact = (Contact){ floorTime, 0.f, 0.f };
+                reachesFloor = true;
+            }
+        }
+
+        // Bricks reached before anything else are handled first
+        PROFILE_BEGIN(PHASE_COLLISIONS);
+        float used = handleBallBrickCollisions(state, ball, contact.time, hits);
+        PROFILE_END(PHASE_COLLISIONS);
+        if (used >= 0) {
+            elapsed += used;
+            continue;
+        }
+
+        advanceBall(ball, contact.time);
+        elapsed += contact.time;
+        if (reachesFloor) {
+            hits->lost = true;
+            break;
+        }
+        reflectBall(ball, contact.nx, contact.ny);
+    }
+    return elapsed;
+}
+
+// xorshift32: small, fast and identical on every platform
+static uint32_t nextRandom(uint32_t *rng) {
+    uint32_t x = *rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *rng = x;
+}
+
+float gameRandom(GameState *state) {
+    return (nextRandom(&state->rng) >> 8) * (1.f / 16777216.f);
+}
+
+// Grow the ball pool (by doubling) to hold at least count balls
+bool reserveBalls(GameState *state, int count) {
+    if (count <= state->ballCapacity) {
+        return true;
+    }
+    int capacity = state->ballCapacity > 0 ? state->ballCapacity : 8;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    Ball *balls = realloc(state->balls, sizeof(Ball) * capacity);
+    if (!balls) {
+        return false;
+    }
+    state->balls = balls;
+    BallHits *ballHits = realloc(state->ballHits, sizeof(BallHits) * capacity);
+    if (!ballHits) {
+        return false;
+    }
+    state->ballHits = ballHits;
+    state->ballCapacity = capacity;
+    return true;
+}
+
+// Append a ball to the pool, growing it if needed
+static Ball *addBall(GameState *state) {
+    if (!reserveBalls(state, state->numBalls + 1)) {
+        return NULL;
+    }
+    state->ballHits[state->numBalls].count = 0;
+    state->ballHits[state->numBalls].lost = false;
+    return &state->balls[state->numBalls++];
+}
+
+// Power-up: a destroyed brick may release a second ball heading the other way
+static void maybeSpawnPowerUp(GameState *state, int ballIndex, int brick) {
+    if (state->powerUpChance <= 0 || gameRandom(state) >= state->powerUpChance) {
+        return;
+    }
+    Ball source = state->balls[ballIndex];
+    Ball *ball = addBall(state);
+    if (ball) {
+        *ball = source;
+        const BrickStore *bricks = &state->bricks;
+        ball->x = brickX(bricks, brick) + (brickWidth(bricks, brick) - ball->size) / 2;
+        ball->y = brickY(bricks, brick) + brickHeight(bricks, brick);
+        ball->prevX = ball->x;
+        ball->prevY = ball->y;
+        ball->dx = -source.dx;
+        ball->dy = fabsf(source.dy);
+    }
+}
+
+// Apply every ball's hits in ball order: each ball to reach a standing
+// brick takes a hit off it, and the one that takes its last destroys it
+// (and scores); later balls only bounce off it. The result does not
+// depend on how balls were spread over threads. Lost balls are then
+// removed, keeping the others in order.
+static void mergeBallHits(GameState *state) {
+    int numBalls = state->numBalls;  // Power-ups spawned below wait a step
+    for (int b = 0; b < numBalls; ++b) {
+        // Index afresh each time: a power-up may reallocate the pool
+        for (int h = 0; h < state->ballHits[b].count; ++h) {
+            int brick = state->ballHits[b].bricks[h];
+            if (isBrickActive(&state->bricks, brick) && hitBrick(state, brick)) {
+                maybeSpawnPowerUp(state, b, brick);
+            }
+        }
+        state->ballHits[b].count = 0;
+    }
+
+    int kept = 0;
+    for (int b = 0; b < state->numBalls; ++b) {
+        if (!state->ballHits[b].lost) {
+            state->balls[kept] = state->balls[b];
+            state->ballHits[kept] = state->ballHits[b];
+            kept++;
+        }
+    }
+    state->numBalls = kept;
+}
+
+// End the game once every brick is gone or the last ball is lost
+static void checkGameEnd(GameState *state) {
+    if (areAllBricksDestroyed(state)) {
+        state->playerWon = true;
+        state->gameOver = true;
+    } else if (state->numBalls == 0) {
+        state->gameOver = true;
+    }
+}
+
+// Allocate the brick storage and ball pool and put every element in its
+// starting position
+bool initGame(GameState *state, int numBricks) {
+    BrickStore bricks;
+    if (!initBuiltInBricks(&bricks, numBricks)) {
+        memset(state, 0, sizeof(*state));
+        return false;
+    }
+    return initGameWithBricks(state, &bricks);
+}
+
+bool initGameWithBricks(GameState *state, const BrickStore *bricks) {
+    memset(state, 0, sizeof(*state));
+    state->bricks = *bricks;
+    state->ballCapacity = 8;
+    state->balls = malloc(sizeof(Ball) * state->ballCapacity);
+    state->ballHits = malloc(sizeof(BallHits) * state->ballCapacity);
+    // A lattice needs no index: its bricks are found from their position
+    bool lattice = bricks->lattice.cols > 0;
+    if (!state->balls || !state->ballHits || (!lattice && !initBrickGrid(&state->grid, &state->bricks))) {
+        freeGame(state);
+        return false;
+    }
+    if (lattice) {
+        state->collisionMode = COLLIDE_LATTICE;
+    } else {
+        state->collisionMode = bricks->count <= BRUTE_FORCE_MAX_BRICKS ? COLLIDE_BRUTE_FORCE : COLLIDE_GRID;
+    }
+    state->seed = 1;
+    resetGame(state);
+    return true;
+}
+
+// Send the ball upwards at a random angle, as fast as a normal launch
+static void launchBall(GameState *state, Ball *ball) {
+    const float degrees = 3.14159265f / 180.f;
+    float angle = (MIN_LAUNCH_ANGLE + gameRandom(state) * (MAX_LAUNCH_ANGLE - MIN_LAUNCH_ANGLE)) * degrees;
+    float speed = BALL_SPEED * sqrtf(2.f);
+    ball->dx = speed * cosf(angle);
+    ball->dy = -speed * sinf(angle);
+}
+
+// Restart the game without reallocating anything
+void resetGame(GameState *state) {
+    state->score = 0;
+    state->gameOver = false;
+    state->playerWon = false;
+    state->rng = state->seed ? state->seed : 1;
+    initPaddle(&state->paddle);
+    state->numBalls = 1;
+    initBall(&state->balls[0]);
+    if (state->randomLaunch) {
+        launchBall(state, &state->balls[0]);
+    }
+    state->ballHits[0].count = 0;
+    state->ballHits[0].lost = false;
+    activateAllBricks(&state->bricks);
+    fillBrickGrid(&state->grid, &state->bricks);
+    state->brickEvents.count = 0;
+    state->brickEvents.rebuild = true;
+    clearBrickDamage(state);
+}
+
+void clearBrickEvents(GameState *state) {
+    state->brickEvents.count = 0;
+    state->brickEvents.rebuild = false;
+}
+
+void freeGame(GameState *state) {
+    freeBrickGrid(&state->grid);
+    freeBrickStore(&state->bricks);
+    free(state->balls);
+    free(state->ballHits);
+    state->balls = NULL;
+    state->ballHits = NULL;
+    state->numBalls = state->ballCapacity = 0;
+}
+
+// Add count balls at random positions in the lower half of the screen
+bool spawnBalls(GameState *state, int count) {
+    for (int n = 0; n < count; ++n) {
+        Ball *ball = addBall(state);
+        if (!ball) {
+            return false;
+        }
+        initBall(ball);
+        ball->x = gameRandom(state) * (SCREEN_WIDTH - ball->size);
+        ball->y = SCREEN_HEIGHT / 2 + gameRandom(state) * (SCREEN_HEIGHT / 2 - 100);
+        ball->dx = BALL_SPEED * (0.25f + gameRandom(state)) * (gameRandom(state) < 0.5f ? -1.f : 1.f);
+        ball->prevX = ball->x;
+        ball->prevY = ball->y;
+    }
+    return true;
+}
+
+// Below this many balls a step is cheaper on one thread
+static const int PARALLEL_MIN_BALLS = 64;
+
+// Balls handed to a worker at a time
+static const int BALLS_PER_TASK = 32;
+
+typedef struct {
+    GameState *state;
+    float dt;
+} BallStepTask;
+
+// Move balls [begin, end); each touches only its own ball and hit list
+static void stepBallRange(void *context, int begin, int end, int worker) {
+    const BallStepTask *task = context;
+    GameState *state = task->state;
+    (void)worker;
+    for (int b = begin; b < end; ++b) {
+        Ball *ball = &state->balls[b];
+        ball->prevX = ball->x;
+        ball->prevY = ball->y;
+        moveBall(state, ball, &state->ballHits[b], task->dt, MAX_BOUNCES_PER_STEP);
+    }
+}
+
+// Advance the simulation by one fixed step of dt seconds
+void stepGame(GameState *state, const GameInput *input, float dt) {
+    Paddle *paddle = &state->paddle;
+
+    clearBrickDamage(state);
+    if (state->gameOver) {
+        return;
+    }
+
+    // Move paddle, keeping it on screen
+    paddle->prevX = paddle->x;
+    paddle->prevY = paddle->y;
+    paddle->x += input->paddleDx;
+    if (paddle->x < 0) {
+        paddle->x = 0;
+    }
+    if (paddle->x > SCREEN_WIDTH - PADDLE_WIDTH) {
+        paddle->x = SCREEN_WIDTH - PADDLE_WIDTH;
+    }
+
+    // Move every ball, resolving every collision along its path; bricks
+    // stay untouched until all balls have moved
+    BallStepTask task = { state, dt };
+    if (state->pool && state->numBalls >= PARALLEL_MIN_BALLS) {
+        parallelFor(state->pool, state->numBalls, BALLS_PER_TASK, stepBallRange, &task);
+    } else {
+        stepBallRange(&task, 0, state->numBalls, 0);
+    }
+    mergeBallHits(state);
+    checkGameEnd(state);
+}
+
+// Event-driven advance: with the paddle held still, fly the balls straight
+// to the next contact (at most maxTime seconds ahead), resolve it and
+// return the time that passed. Straight flight costs nothing per frame,
+// so long stretches of a game take a handful of calls.
+float advanceToNextEvent(GameState *state, float maxTime) {
+    clearBrickDamage(state);
+    if (state->gameOver) {
+        return 0.f;
+    }
+
+    // With several balls, find the soonest contact on scratch copies first
+    float next = maxTime;
+    if (state->numBalls > 1) {
+        for (int b = 0; b < state->numBalls; ++b) {
+            Ball probe = state->balls[b];
+            BallHits scratch;
+            scratch.count = 0;
+            scratch.lost = false;
+            next = fminf(next, moveBall(state, &probe, &scratch, next, 1));
+        }
+    }
+
+    // Fly every ball that far; the ones in contact resolve it
+    for (int b = 0; b < state->numBalls; ++b) {
+        float used = moveBall(state, &state->balls[b], &state->ballHits[b], next, 1);
+        if (state->numBalls == 1) {
+            next = used;
+        }
+    }
+    mergeBallHits(state);
+    checkGameEnd(state);
+    return next;
+}
@@ -0,0 +1,183 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bricks.h"
+#include "grid.h"
+#include "threadpool.h"
+
+// Screen dimension constants
+static const int SCREEN_WIDTH = 880;
+static const int SCREEN_HEIGHT = 800;
+
+// Game element dimensions
+static const int PADDLE_WIDTH = 400;
+static const int PADDLE_HEIGHT = 20;
+static const int BALL_SIZE = 15;
+static const int BRICK_WIDTH = 80;
+static const int BRICK_HEIGHT = 30;
+static const int NUM_BRICKS = 20;
+
+// Paddle movement per key press
+static const int PADDLE_SPEED = 20;
+
+// Paddle speed while a direction is held, in pixels per second
+static const float PADDLE_VELOCITY = 900.f;
+
+// Ball speed along each axis, in pixels per second
+static const float BALL_SPEED = 600.f;
+
+// Default physics rate; game speed does not depend on it
+static const int PHYSICS_HZ = 120;
+
+// Launch angles allowed by randomLaunch, in degrees from the horizontal
+static const float MIN_LAUNCH_ANGLE = 30.f;
+static const float MAX_LAUNCH_ANGLE = 150.f;
+
+// Default chance that a destroyed brick releases an extra ball when
+// multi-ball power-ups are enabled
+static const float POWER_UP_CHANCE = 0.15f;
+
+// Structures for game elements. prevX/prevY hold the position at the
+// start of the last step so rendering can interpolate.
+typedef struct {
+    float x, y;
+    float width, height;
+    float prevX, prevY;
+} Paddle;
+
+typedef struct {
+    float x, y;
+    float dx, dy;
+    float size;
+    float prevX, prevY;
+} Ball;
+
+// Bricks one ball hit during the current step. Balls move independently
+// (possibly on different threads) against the bricks as they were at the
+// start of the step; hits are merged afterwards in ball order.
+#define MAX_BALL_HITS 32
+
+typedef struct {
+    int bricks[MAX_BALL_HITS];
+    int count;
+    bool lost;  // Reached the floor this step
+} BallHits;
+
+// Bricks destroyed since a consumer (e.g. a cached brick layer) last
+// looked. rebuild means the list is incomplete: the level was reset or
+// more bricks went than fit, and the consumer must start over.
+#define MAX_BRICK_EVENTS 256
+
+typedef struct {
+    int destroyed[MAX_BRICK_EVENTS];
+    int count;
+    bool rebuild;
+} BrickEvents;
+
+// Bricks that took a hit in the last step and still stand, once per hit,
+// so the hit can be undone (rewind). overflow means more hits landed than
+// fit and the list is incomplete.
+typedef struct {
+    int bricks[MAX_BRICK_EVENTS];
+    int count;
+    bool overflow;
+} BrickDamage;
+
+// How ball-brick overlaps are found
+typedef enum {
+    COLLIDE_GRID,         // Uniform grid lookup, cost independent of brick count
+    COLLIDE_BRUTE_FORCE,  // SIMD scan of every brick, for tiny or dense levels
+    COLLIDE_LATTICE       // Direct lookup of the bricks under the ball, lattice levels only
+} CollisionMode;
+
+// Levels up to this size use the brute-force scan by default; around this
+// count an AVX2 scan and a grid lookup cost about the same per step
+static const int BRUTE_FORCE_MAX_BRICKS = 32;
+
+// First contact of a moving ball with a surface
+typedef struct {
+    float time;    // Seconds until the ball touches the surface
+    float nx, ny;  // Surface normal, pointing back towards the ball
+} Contact;
+
+// Player input applied during a single simulation step
+typedef struct {
+    float paddleDx; // Horizontal paddle displacement requested for this step
+} GameInput;
+
+// Complete simulation state, independent of any window or renderer
+typedef struct {
+    Paddle paddle;
+
+    // Contiguous ball pool; ballHits is parallel to balls
+    Ball *balls;
+    BallHits *ballHits;
+    int numBalls;
+    int ballCapacity;
+
+    BrickStore bricks;
+    BrickGrid grid;  // Spatial index of the active bricks; unused on a lattice
+    CollisionMode collisionMode;
+    BrickEvents brickEvents;
+    BrickDamage damage;
+
+    ThreadPool *pool;     // Optional; spreads ball updates over threads
+    float powerUpChance;  // Chance a destroyed brick spawns a ball (0 = off)
+    bool solidFloor;      // Balls bounce off the floor (stress tests)
+    bool randomLaunch;    // Reset launches the ball at a random angle
+    uint32_t seed;        // Seeds rng on reset
+    uint32_t rng;
+
+    int score;
+    bool gameOver;
+    bool playerWon;
+} GameState;
+
+// Initialize game elements
+void initPaddle(Paddle *paddle);
+void initBall(Ball *ball);
+// The built-in level (rows of ten bricks) as a lattice, or written into a
+// store with explicit geometry
+bool initBuiltInBricks(BrickStore *bricks, int numBricks);
+void initBricks(BrickStore *bricks);
+
+// Collision helpers
+bool checkCollision(const Ball *ball, const BrickStore *bricks, int i);
+bool sweepBall(const Ball *ball, float minX, float minY, float maxX, float maxY,
+               float maxTime, Contact *contact);
+bool areAllBricksDestroyed(const GameState *state);
+float handleBallBrickCollisions(const GameState *state, Ball *ball, float maxTime, BallHits *hits);
+
+// Game state lifetime. initGame builds the built-in level of numBricks
+// bricks; initGameWithBricks takes over a prepared store (e.g. a level
+// file's), which freeGame releases, even when it fails.
+bool initGame(GameState *state, int numBricks);
+bool initGameWithBricks(GameState *state, const BrickStore *bricks);
+void resetGame(GameState *state);
+void freeGame(GameState *state);
+
+// Forget the brick events once they have been applied
+void clearBrickEvents(GameState *state);
+
+// Make room for count balls; false if the pool cannot grow
+bool reserveBalls(GameState *state, int count);
+
+// Add count balls at random positions in the lower half of the screen,
+// heading upwards (stress tests); false if the pool cannot grow
+bool spawnBalls(GameState *state, int count);
+
+// Deterministic random number in [0, 1) from the game's generator
+float gameRandom(GameState *state);
+
+// Advance the simulation by one fixed step of dt seconds
+void stepGame(GameState *state, const GameInput *input, float dt);
+
+// Event-driven alternative to stepGame while the input is idle: jump to
+// the next contact of any ball (at most maxTime ahead), resolve it and
+// return the seconds that passed
+float advanceToNextEvent(GameState *state, float maxTime);
+
+#endif
@@ -0,0 +1,151 @@
+#include "grid.h"
+#include "game.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+static int clampInt(int value, int low, int high) {
+    return value < low ? low : (value > high ? high : value);
+}
+
+// Most cells a grid may have (32 MB of cell tables)
+static const int MAX_GRID_CELLS = 1 << 22;
+
+// Cell containing the top-left corner of a brick
+static int homeCell(const BrickGrid *grid, const BrickStore *bricks, int i) {
+    int col = (int)((brickX(bricks, i) - grid->originX) / grid->cellWidth);
+    int row = (int)((brickY(bricks, i) - grid->originY) / grid->cellHeight);
+    return clampInt(row, 0, grid->rows - 1) * grid->cols + clampInt(col, 0, grid->cols - 1);
+}
+
+// Size the grid to the brick field; its cells start empty
+bool initBrickGrid(BrickGrid *grid, const BrickStore *bricks) {
+    int numBricks = bricks->count;
+    // Cells are brick sized, grown if the level has larger bricks
+    float cellWidth = BRICK_WIDTH, cellHeight = BRICK_HEIGHT;
+    float minX = 0, minY = 0, maxX = 1, maxY = 1;
+    for (int i = 0; i < numBricks; ++i) {
+        float x = brickX(bricks, i), y = brickY(bricks, i);
+        float width = brickWidth(bricks, i), height = brickHeight(bricks, i);
+        if (width > cellWidth) {
+            cellWidth = width;
+        }
+        if (height > cellHeight) {
+            cellHeight = height;
+        }
+        if (i == 0 || x < minX) {
+            minX = x;
+        }
+        if (i == 0 || y < minY) {
+            minY = y;
+        }
+        if (i == 0 || x + width > maxX) {
+            maxX = x + width;
+        }
+        if (i == 0 || y + height > maxY) {
+            maxY = y + height;
+        }
+    }
+
+    // A sparse, spread-out level would need more cells than it has bricks
+    // many times over; grow the cells until the grid fits the cap. Larger
+    // cells only mean more bricks per cell.
+    double cols, rows;
+    for (;;) {
+        cols = fmax(ceil((maxX - minX) / cellWidth), 1.0);
+        rows = fmax(ceil((maxY - minY) / cellHeight), 1.0);
+        double cells = cols * rows;
+        if (cells <= MAX_GRID_CELLS) {
+            break;
+        }
+        double grow = sqrt(cells / MAX_GRID_CELLS) * 1.01;
+        cellWidth = (float)(cellWidth * grow);
+        cellHeight = (float)(cellHeight * grow);
+    }
+
+    grid->originX = minX;
+    grid->originY = minY;
+    grid->cellWidth = cellWidth;
+    grid->cellHeight = cellHeight;
+    grid->cols = (int)cols;
+    grid->rows = (int)rows;
+
+    int numCells = (int)(cols * rows);  // At most MAX_GRID_CELLS
+    grid->cellStart = malloc(sizeof(int) * (numCells + 1));
+    grid->cellCount = malloc(sizeof(int) * numCells);
+    grid->cellBricks = malloc(sizeof(int) * (numBricks > 0 ? numBricks : 1));
+    if (!grid->cellStart || !grid->cellCount || !grid->cellBricks) {
+        freeBrickGrid(grid);
+        return false;
+    }
+
+    // Slot ranges are fixed for the lifetime of the grid: every brick,
+    // active or not, owns one slot in its home cell's range
+    for (int c = 0; c <= numCells; ++c) {
+        grid->cellStart[c] = 0;
+    }
+    for (int i = 0; i < numBricks; ++i) {
+        grid->cellStart[homeCell(grid, bricks, i) + 1]++;
+    }
+    for (int c = 0; c < numCells; ++c) {
+        grid->cellStart[c + 1] += grid->cellStart[c];
+        grid->cellCount[c] = 0;
+    }
+    return true;
+}
+
+void freeBrickGrid(BrickGrid *grid) {
+    free(grid->cellStart);
+    free(grid->cellCount);
+    free(grid->cellBricks);
+    grid->cellStart = NULL;
+    grid->cellCount = NULL;
+    grid->cellBricks = NULL;
+    grid->cols = grid->rows = 0;
+}
+
+// Re-insert every active brick, e.g. after the level is reset
+void fillBrickGrid(BrickGrid *grid, const BrickStore *bricks) {
+    if (!grid->cellStart) {
+        return;  // Never built: the game collides on a lattice
+    }
+    int numCells = grid->cols * grid->rows;
+    for (int c = 0; c < numCells; ++c) {
+        grid->cellCount[c] = 0;
+    }
+    for (int i = nextActiveBrick(bricks, 0); i >= 0; i = nextActiveBrick(bricks, i + 1)) {
+        int cell = homeCell(grid, bricks, i);
+        grid->cellBricks[grid->cellStart[cell] + grid->cellCount[cell]++] = i;
+    }
+}
+
+// Cell range whose bricks may overlap the box [minX, maxX) x [minY, maxY)
+void brickGridRange(const BrickGrid *grid, float minX, float minY, float maxX, float maxY,
+                    int *col0, int *row0, int *col1, int *row1) {
+    // A brick reaches at most one cell to the right of / below its home
+    // cell, so widen the box by one cell towards the origin
+    *col0 = clampInt((int)floorf((minX - grid->cellWidth - grid->originX) / grid->cellWidth), 0, grid->cols - 1);
+    *row0 = clampInt((int)floorf((minY - grid->cellHeight - grid->originY) / grid->cellHeight), 0, grid->rows - 1);
+    *col1 = clampInt((int)floorf((maxX - grid->originX) / grid->cellWidth), 0, grid->cols - 1);
+    *row1 = clampInt((int)floorf((maxY - grid->originY) / grid->cellHeight), 0, grid->rows - 1);
+}
+
+// Remove a brick from its cell when it is deactivated
+void removeBrickFromGrid(BrickGrid *grid, const BrickStore *bricks, int brickIndex) {
+    int cell = homeCell(grid, bricks, brickIndex);
+    int *slots = &grid->cellBricks[grid->cellStart[cell]];
+    int count = grid->cellCount[cell];
+    for (int s = 0; s < count; ++s) {
+        if (slots[s] == brickIndex) {
+            slots[s] = slots[count - 1];
+            grid->cellCount[cell] = count - 1;
+            return;
+        }
+    }
+}
+
+// Every brick owns a slot in its home cell's range, so there is always room
+void addBrickToGrid(BrickGrid *grid, const BrickStore *bricks, int brickIndex) {
+    int cell = homeCell(grid, bricks, brickIndex);
+    grid->cellBricks[grid->cellStart[cell] + grid->cellCount[cell]++] = brickIndex;
+}
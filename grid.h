@@ -0,0 +1,40 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <stdbool.h>
+
+#include "bricks.h"
+
+// Uniform grid over the brick field. Each active brick is stored in the
+// cell that contains its top-left corner; cells are at least as large as
+// the largest brick, so a query only has to look one cell up and to the
+// left of the box it is testing.
+typedef struct {
+    float originX, originY;
+    float cellWidth, cellHeight;
+    int cols, rows;
+    int *cellStart;   // First slot of each cell in cellBricks
+    int *cellCount;   // Active bricks currently stored in each cell
+    int *cellBricks;  // Brick indices grouped by cell
+} BrickGrid;
+
+// Size the grid to the bricks with every cell empty; fillBrickGrid inserts
+// them. Levels spread over a huge area get cells larger than their bricks,
+// so the grid stays within a fixed number of cells.
+bool initBrickGrid(BrickGrid *grid, const BrickStore *bricks);
+void freeBrickGrid(BrickGrid *grid);
+
+// Re-insert every active brick, e.g. after the level is reset
+void fillBrickGrid(BrickGrid *grid, const BrickStore *bricks);
+
+// Cell range whose bricks may overlap the box [minX, maxX) x [minY, maxY)
+void brickGridRange(const BrickGrid *grid, float minX, float minY, float maxX, float maxY,
+                    int *col0, int *row0, int *col1, int *row1);
+
+// Remove a brick from its cell when it is deactivated
+void removeBrickFromGrid(BrickGrid *grid, const BrickStore *bricks, int brickIndex);
+
+// Put a reactivated brick back into its cell (e.g. when rewinding)
+void addBrickToGrid(BrickGrid *grid, const BrickStore *bricks, int brickIndex);
+
+#endif
@@ -0,0 +1,300 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "autopilot.h"
+#include "game.h"
+#include "replay.h"
+#include "tournament.h"
+
+// Wall-clock time in seconds
+static double nowSeconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Print non-empty histogram rows from the first to the last used bucket,
+// merging buckets so at most 20 rows are shown
+static void printHistogram(const char *title, const long *counts, int numBuckets, double bucketWidth,
+                           const char *format) {
+    int first = 0, last = numBuckets - 1;
+    while (first < last && counts[first] == 0) {
+        ++first;
+    }
+    while (last > first && counts[last] == 0) {
+        --last;
+    }
+    int group = (last - first) / 20 + 1;
+    long rows[20] = { 0 };
+    long most = 1;
+    int numRows = (last - first) / group + 1;
+    for (int b = first; b <= last; ++b) {
+        rows[(b - first) / group] += counts[b];
+    }
+    for (int r = 0; r < numRows; ++r) {
+        if (rows[r] > most) {
+            most = rows[r];
+        }
+    }
+    printf("  %s\n", title);
+    for (int r = 0; r < numRows; ++r) {
+        char label[32];
+        snprintf(label, sizeof(label), format, (first + r * group) * bucketWidth);
+        int bar = (int)(rows[r] * 50 / most);
+        printf("  %10s %9ld  %.*s\n", label, rows[r], bar, "##################################################");
+    }
+}
+
+// Play numGames seeded games with every autopilot across all cores and
+// print how each fared
+static int runTournaments(const TournamentSettings *settings) {
+    printf("tournament: %d games per autopilot, %d bricks, seeds %u-%u, up to %.0f s per game\n",
+           settings->numGames, settings->level ? levelBrickCount(settings->level) : settings->numBricks,
+           settings->firstSeed,
+           settings->firstSeed + (uint32_t)settings->numGames - 1, settings->maxGameTime);
+    printf("%-10s %8s %6s %8s %5s %5s %5s %9s %9s %10s\n", "autopilot", "games", "win%", "score",
+           "p10", "p50", "p90", "length", "timeouts", "games/s");
+    TournamentResult results[NUM_AUTOPILOTS];
+    for (int a = 0; a < NUM_AUTOPILOTS; ++a) {
+        double start = nowSeconds();
+        if (!runTournament(settings, (Autopilot)a, &results[a])) {
+            for (int f = 0; f < a; ++f) {
+                freeTournamentResult(&results[f]);
+            }
+            return 1;
+        }
+        double elapsed = nowSeconds() - start;
+        const TournamentResult *result = &results[a];
+        double games = result->games > 0 ? (double)result->games : 1.0;
+        printf("%-10s %8ld %6.1f %8.2f %5d %5d %5d %8.1fs %9ld %10.0f\n",
+               autopilotName((Autopilot)a), result->games, 100.0 * result->wins / games,
+               result->totalScore / games, tournamentScorePercentile(result, 0.1),
+               tournamentScorePercentile(result, 0.5), tournamentScorePercentile(result, 0.9),
+               result->totalTime / games, result->timeouts, elapsed > 0 ? result->games / elapsed : 0.0);
+    }
+    for (int a = 0; a < NUM_AUTOPILOTS; ++a) {
+        const TournamentResult *result = &results[a];
+        printf("\n%s\n", autopilotName((Autopilot)a));
+        printHistogram("bricks destroyed (= score)", result->scoreHistogram, result->numBricks + 1, 1.0, "%.0f");
+        printHistogram("game length", result->lengthHistogram, TOURNAMENT_LENGTH_BUCKETS,
+                       settings->maxGameTime / TOURNAMENT_LENGTH_BUCKETS, "%.1fs");
+        freeTournamentResult(&results[a]);
+    }
+    return 0;
+}
+
+// Play a recording back and compare the final state with the recorded one
+static int runReplay(const char *path) {
+    Replay replay;
+    if (!loadReplay(&replay, path)) {
+        return 1;
+    }
+    GameState game;
+    double start = nowSeconds();
+    if (!playReplay(&replay, &game)) {
+        printf("Failed to allocate game state!\n");
+        freeReplay(&replay);
+        return 1;
+    }
+    double elapsed = nowSeconds() - start;
+    uint64_t hash = hashGameState(&game);
+    bool match = hash == replay.finalHash;
+
+    printf("replay: %llu steps in %.3f s (%.0f steps/s)  score: %d\n",
+           (unsigned long long)replay.numSteps, elapsed,
+           elapsed > 0 ? replay.numSteps / elapsed : 0.0, game.score);
+    printf("final state: %016llx  recorded: %016llx  %s\n",
+           (unsigned long long)hash, (unsigned long long)replay.finalHash,
+           match ? "OK" : "MISMATCH");
+
+    freeGame(&game);
+    freeReplay(&replay);
+    return match ? 0 : 1;
+}
+
+static void printUsage(const char *program) {
+    printf("usage: %s [--games N] [--steps N] [--bricks N] [--hz N] [--predict] [--events]\n"
+           "          [--balls N] [--threads N] [--powerups P] [--solid-floor]\n"
+           "          [--random-launch] [--level FILE] [--record FILE] [--replay FILE] [--tournament]\n"
+           "  --predict      steer with the landing-point autopilot instead of tracking the ball\n"
+           "  --events       jump straight to the next collision while the paddle is idle\n"
+           "  --balls N      start each game with N balls\n"
+           "  --threads N    move balls on N threads (0: one per hardware thread)\n"
+           "  --powerups P   chance that a destroyed brick releases another ball\n"
+           "  --solid-floor  balls bounce off the bottom of the screen instead of being lost\n"
+           "  --random-launch  launch the ball at a random angle (seeded per game)\n"
+           "  --level FILE   play a binary level made with makelevel instead of --bricks\n"
+           "  --record FILE  save the inputs of the first game for --replay\n"
+           "  --replay FILE  re-run a recorded game at full speed and check its final state\n"
+           "  --tournament   play --games seeded games with every autopilot on all cores\n"
+           "                 (or --threads) and print score and game length histograms\n",
+           program);
+}
+
+int main(int argc, char* argv[])
+{
+    int numGames = 1000;
+    long maxSteps = 100000;
+    int numBricks = NUM_BRICKS;
+    float hz = (float)PHYSICS_HZ;
+    bool predict = false;
+    bool events = false;
+    int numBalls = 1;
+    int numThreads = 1;
+    float powerUpChance = 0.f;
+    bool solidFloor = false;
+    bool randomLaunch = false;
+    bool tournament = false;
+    int tournamentThreads = 0;
+    const char *recordPath = NULL;
+    const char *levelPath = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            numGames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            maxSteps = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--bricks") == 0 && i + 1 < argc) {
+            numBricks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--hz") == 0 && i + 1 < argc) {
+            hz = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--predict") == 0) {
+            predict = true;
+        } else if (strcmp(argv[i], "--events") == 0) {
+            events = true;
+        } else if (strcmp(argv[i], "--balls") == 0 && i + 1 < argc) {
+            numBalls = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            numThreads = tournamentThreads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--powerups") == 0 && i + 1 < argc) {
+            powerUpChance = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--solid-floor") == 0) {
+            solidFloor = true;
+        } else if (strcmp(argv[i], "--random-launch") == 0) {
+            randomLaunch = true;
+        } else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+            levelPath = argv[++i];
+        } else if (strcmp(argv[i], "--tournament") == 0) {
+            tournament = true;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            return runReplay(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (recordPath && events) {
+        printf("--record only records fixed steps; drop --events\n");
+        return 1;
+    }
+    if (recordPath && levelPath) {
+        printf("--record only records the built-in level; drop --level\n");
+        return 1;
+    }
+
+    // Opening only maps the file; the pages are read as the bricks are
+    // first touched, which the load time below includes
+    double loadStart = nowSeconds();
+    Level *level = NULL;
+    if (levelPath) {
+        level = openLevel(levelPath);
+        if (!level) {
+            return 1;
+        }
+    }
+
+    if (tournament) {
+        TournamentSettings settings = {
+            numGames, 1, numBricks, level, 1.f / hz, maxSteps / hz, powerUpChance, tournamentThreads
+        };
+        int status = runTournaments(&settings);
+        closeLevel(level);
+        return status;
+    }
+
+    GameState game;
+    BrickStore bricks;
+    bool ready = level ? initLevelBricks(level, &bricks) && initGameWithBricks(&game, &bricks)
+                       : initGame(&game, numBricks);
+    if (!ready) {
+        printf("Failed to allocate game state!\n");
+        closeLevel(level);
+        return 1;
+    }
+    if (level) {
+        printf("level: %d bricks loaded in %.1f ms\n", game.bricks.count, (nowSeconds() - loadStart) * 1e3);
+    }
+    game.powerUpChance = powerUpChance;
+    game.solidFloor = solidFloor;
+    game.randomLaunch = randomLaunch;
+    if (numThreads != 1) {
+        game.pool = createThreadPool(numThreads);
+    }
+
+    long long totalUpdates = 0;
+    long long totalScore = 0;
+    double totalGameTime = 0.0;
+    int wins = 0;
+    const float dt = 1.f / hz;
+    const float maxGameTime = maxSteps * dt;
+    double start = nowSeconds();
+
+    for (int g = 0; g < numGames; ++g) {
+        game.seed = (uint32_t)g + 1;  // Same games on every run
+        resetGame(&game);
+        if (numBalls > 1 && !spawnBalls(&game, numBalls - 1)) {
+            printf("Failed to allocate balls!\n");
+            break;
+        }
+        Replay replay;
+        bool recording = recordPath && g == 0 && initReplay(&replay, &game, dt, numBalls - 1);
+        float gameTime = 0.f;
+        while (!game.gameOver && gameTime < maxGameTime) {
+            GameInput input = autopilotInput(predict ? AUTOPILOT_PREDICT : AUTOPILOT_TRACK, &game);
+            if (events && input.paddleDx == 0) {
+                // Nothing to steer: skip straight to the next collision
+                gameTime += advanceToNextEvent(&game, maxGameTime - gameTime);
+            } else {
+                if (recording) {
+                    recording = recordStep(&replay, &input);
+                }
+                stepGame(&game, &input, dt);
+                gameTime += dt;
+            }
+            ++totalUpdates;
+        }
+        if (recordPath && g == 0) {
+            if (recording) {
+                finishReplay(&replay, &game);
+                saveReplay(&replay, recordPath);
+            } else {
+                printf("Failed to record the game!\n");
+            }
+            freeReplay(&replay);
+        }
+        totalGameTime += gameTime;
+        totalScore += game.score;
+        if (game.playerWon) {
+            ++wins;
+        }
+    }
+
+    double elapsed = nowSeconds() - start;
+    printf("games: %d  wins: %d  avg score: %.2f  avg game time: %.1f s\n",
+           numGames, wins, numGames ? (double)totalScore / numGames : 0.0,
+           numGames ? totalGameTime / numGames : 0.0);
+    printf("threads: %d\n", threadPoolSize(game.pool));
+    printf("updates: %lld in %.3f s (%.0f updates/s, %.0f game-seconds/s)\n",
+           totalUpdates, elapsed, elapsed > 0 ? totalUpdates / elapsed : 0.0,
+           elapsed > 0 ? totalGameTime / elapsed : 0.0);
+
+    destroyThreadPool(game.pool);
+    freeGame(&game);
+    closeLevel(level);
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include "input.h"
+
+#include <string.h>
+
+// Stick deflection below this is treated as centred
+static const Sint16 STICK_DEAD_ZONE = 8000;
+
+void initPaddleControl(PaddleControl *control) {
+    memset(control, 0, sizeof(*control));
+    // Gamepads already connected are reported with SDL_CONTROLLERDEVICEADDED
+}
+
+void closePaddleControl(PaddleControl *control) {
+    if (control->controller) {
+        SDL_GameControllerClose(control->controller);
+        control->controller = NULL;
+    }
+}
+
+static float heldAxis(const PaddleControl *control) {
+    float axis = (float)control->right - (float)control->left + control->stick;
+    return axis < -1.f ? -1.f : axis > 1.f ? 1.f : axis;
+}
+
+// Queue a change of direction at the given time
+static void pushChange(PaddleControl *control, Uint32 time, float axis) {
+    float last = control->numChanges ? control->changes[control->numChanges - 1].axis : control->axis;
+    if (axis == last) {
+        return;
+    }
+    if (axis != 0.f) {
+        control->mouseActive = false;
+    }
+    // Keep the queue in time order; polled changes are dated back
+    if (control->numChanges && time < control->changes[control->numChanges - 1].time) {
+        time = control->changes[control->numChanges - 1].time;
+    }
+    if (control->numChanges == MAX_INPUT_CHANGES) {
+        // Nothing is stepping (paused or game over); keep the newest changes
+        control->axis = control->changes[0].axis;
+        memmove(&control->changes[0], &control->changes[1], sizeof(InputChange) * (MAX_INPUT_CHANGES - 1));
+        --control->numChanges;
+    }
+    control->changes[control->numChanges].time = time;
+    control->changes[control->numChanges].axis = axis;
+    ++control->numChanges;
+}
+
+void handleInputEvent(PaddleControl *control, const SDL_Event *event) {
+    switch (event->type) {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP: {
+            if (event->key.repeat) {
+                return;
+            }
+            bool down = event->type == SDL_KEYDOWN;
+            SDL_Scancode code = event->key.keysym.scancode;
+            if (code == SDL_SCANCODE_LEFT || code == SDL_SCANCODE_A) {
+                control->left = down;
+            } else if (code == SDL_SCANCODE_RIGHT || code == SDL_SCANCODE_D) {
+                control->right = down;
+            } else {
+                return;
+            }
+            pushChange(control, event->key.timestamp, heldAxis(control));
+            break;
+        }
+        case SDL_MOUSEMOTION:
+            control->mouseActive = true;
+            control->mouseX = event->motion.x;
+            break;
+        case SDL_CONTROLLERDEVICEADDED:
+            if (!control->controller) {
+                control->controller = SDL_GameControllerOpen(event->cdevice.which);
+            }
+            break;
+        case SDL_CONTROLLERDEVICEREMOVED:
+            if (control->controller && SDL_GameControllerFromInstanceID(event->cdevice.which) == control->controller) {
+                closePaddleControl(control);
+                control->stick = 0.f;
+                pushChange(control, event->cdevice.timestamp, heldAxis(control));
+            }
+            break;
+    }
+}
+
+void pollPaddleControl(PaddleControl *control, Uint32 now) {
+    // Catch key releases the window missed, e.g. while it lost focus
+    const Uint8 *keys = SDL_GetKeyboardState(NULL);
+    control->left = keys[SDL_SCANCODE_LEFT] || keys[SDL_SCANCODE_A];
+    control->right = keys[SDL_SCANCODE_RIGHT] || keys[SDL_SCANCODE_D];
+
+    control->stick = 0.f;
+    if (control->controller) {
+        Sint16 value = SDL_GameControllerGetAxis(control->controller, SDL_CONTROLLER_AXIS_LEFTX);
+        if (value > STICK_DEAD_ZONE || value < -STICK_DEAD_ZONE) {
+            control->stick = value / 32767.f;
+        }
+        if (SDL_GameControllerGetButton(control->controller, SDL_CONTROLLER_BUTTON_DPAD_LEFT)) {
+            control->stick = -1.f;
+        }
+        if (SDL_GameControllerGetButton(control->controller, SDL_CONTROLLER_BUTTON_DPAD_RIGHT)) {
+            control->stick = 1.f;
+        }
+    }
+    // A polled change happened some time since the last poll; date it
+    // from then so this frame's steps already see it
+    pushChange(control, control->lastPoll ? control->lastPoll : now, heldAxis(control));
+    control->lastPoll = now;
+
+    if (control->mouseActive) {
+        SDL_GetMouseState(&control->mouseX, NULL);
+    }
+}
+
+// Count the change as used by a step, for the latency figures
+static void useChange(PaddleControl *control) {
+    const InputChange *change = &control->changes[0];
+    if (!control->hasUnpresented || change->time < control->unpresented) {
+        control->unpresented = change->time;
+        control->hasUnpresented = true;
+    }
+    control->axis = change->axis;
+    memmove(&control->changes[0], &control->changes[1], sizeof(InputChange) * (control->numChanges - 1));
+    --control->numChanges;
+}
+
+float paddleStepInput(PaddleControl *control, const Paddle *paddle, double start, double end, float dt) {
+    // Changes from before the step only decide how it starts
+    while (control->numChanges && control->changes[0].time <= start) {
+        useChange(control);
+    }
+
+    // Integrate the direction over the step's time slice
+    double time = start, pushed = 0.0;
+    while (control->numChanges && control->changes[0].time < end) {
+        pushed += control->axis * (control->changes[0].time - time);
+        time = control->changes[0].time;
+        useChange(control);
+    }
+    pushed += control->axis * (end - time);
+
+    if (control->mouseActive) {
+        return control->mouseX - paddle->width / 2 - paddle->x;
+    }
+    return (float)(pushed / (end - start)) * PADDLE_VELOCITY * dt;
+}
+
+void inputPresented(PaddleControl *control, Uint32 now) {
+    if (!control->hasUnpresented) {
+        return;
+    }
+    double latency = (double)(Uint32)(now - control->unpresented);
+    control->latencyTotal += latency;
+    if (latency > control->latencyMax) {
+        control->latencyMax = latency;
+    }
+    ++control->latencyCount;
+    control->hasUnpresented = false;
+}
@@ -0,0 +1,63 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+#include "game.h"
+
+// Paddle control from keyboard (arrows or A/D), gamepad and mouse.
+// Key presses and releases are kept with their event timestamps, and each
+// physics step is given the fraction of its time slice the paddle was
+// being pushed, so motion does not depend on key repeat and an input is
+// felt by the first step it falls into. The keyboard, gamepad and mouse
+// are sampled again right before the steps are run.
+
+#define MAX_INPUT_CHANGES 64
+
+typedef struct {
+    Uint32 time;  // SDL ticks
+    float axis;
+} InputChange;
+
+typedef struct {
+    bool left, right;   // Keys held
+    float stick;        // Gamepad stick and D-pad, -1 to 1
+    SDL_GameController *controller;
+
+    // Direction (-1 to 1) used by the last step, and the changes after
+    // it that no step has used yet
+    float axis;
+    InputChange changes[MAX_INPUT_CHANGES];
+    int numChanges;
+    Uint32 lastPoll;
+
+    // The paddle follows the mouse after it moves, until a key is used
+    bool mouseActive;
+    int mouseX;
+
+    // Input-to-present latency: the oldest input used by a step that is
+    // not on screen yet, and totals over the session
+    Uint32 unpresented;
+    bool hasUnpresented;
+    double latencyTotal, latencyMax;
+    int latencyCount;
+} PaddleControl;
+
+void initPaddleControl(PaddleControl *control);
+void closePaddleControl(PaddleControl *control);
+
+// Update held keys, mouse and gamepad from an event; key repeats are ignored
+void handleInputEvent(PaddleControl *control, const SDL_Event *event);
+
+// Sample the current device state; call after the events are pumped and
+// right before stepping
+void pollPaddleControl(PaddleControl *control, Uint32 now);
+
+// Paddle displacement for the step covering SDL ticks [start, end)
+float paddleStepInput(PaddleControl *control, const Paddle *paddle, double start, double end, float dt);
+
+// Call once the frame showing the latest steps has been presented
+void inputPresented(PaddleControl *control, Uint32 now);
+
+#endif
@@ -0,0 +1,766 @@
+#include "leaderboard.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char LEADERBOARD_MAGIC[4] = { 'B', 'R', 'K', 'L' };
+static const uint32_t LEADERBOARD_VERSION = 1;
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// Capacities of a new file; each doubles when it fills up
+static const uint32_t INITIAL_PLAYERS = 64;
+static const uint32_t INITIAL_BEST_SLOTS = 256;
+static const uint32_t INITIAL_RECORDS = 4096;
+
+// File layout: header, players, player index, best index, top tables and
+// records, each section at an offset stored in the header. Records come
+// last so the common growth is just a longer file.
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t dirty;  // Set while a record is added; indexes are rebuilt if found set
+
+    uint32_t numPlayers, playerCapacity;
+    uint32_t playerSlots;         // Player index size, twice playerCapacity
+    uint32_t numBest, bestSlots;  // Best-per-level index entries and size
+    uint32_t numRecords, recordCapacity;
+    uint32_t reserved;
+
+    uint64_t playerOffset, playerIndexOffset, bestIndexOffset, topOffset, recordOffset;
+    uint64_t fileSize;
+} FileHeader;
+
+typedef struct {
+    char name[MAX_PLAYER_NAME];  // Zero padded, so names compare with memcmp
+    uint32_t hash;
+    uint32_t numRecords;
+    uint32_t lastRecord;  // Newest record + 1, 0 for none
+    uint32_t reserved;
+} PlayerRecord;
+
+typedef struct {
+    uint32_t player;
+    uint32_t level;
+    int32_t score;
+    uint32_t prevByPlayer;  // The player's previous record + 1, 0 for none
+    int64_t time;
+} ScoreRecord;
+
+// Record indices sorted by score, highest first
+typedef struct {
+    uint32_t count;
+    uint32_t records[LEADERBOARD_TOP];
+} TopTable;
+
+struct Leaderboard {
+    char *path;
+#ifdef _WIN32
+    HANDLE file, mapping;
+#else
+    int fd;
+#endif
+    uint8_t *base;  // Mapped file, NULL if it could not be mapped again
+    size_t size;
+};
+
+// Sections of the mapped file
+
+static FileHeader *header(const Leaderboard *board) {
+    return (FileHeader *)board->base;
+}
+
+static PlayerRecord *players(const Leaderboard *board) {
+    return (PlayerRecord *)(board->base + header(board)->playerOffset);
+}
+
+static uint32_t *playerIndex(const Leaderboard *board) {
+    return (uint32_t *)(board->base + header(board)->playerIndexOffset);
+}
+
+static uint32_t *bestIndex(const Leaderboard *board) {
+    return (uint32_t *)(board->base + header(board)->bestIndexOffset);
+}
+
+static TopTable *topTables(const Leaderboard *board) {
+    return (TopTable *)(board->base + header(board)->topOffset);
+}
+
+static ScoreRecord *records(const Leaderboard *board) {
+    return (ScoreRecord *)(board->base + header(board)->recordOffset);
+}
+
+static uint64_t alignUp(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+// Place the sections for the given capacities
+static void layoutHeader(FileHeader *h, uint32_t playerCapacity, uint32_t bestSlots, uint32_t recordCapacity) {
+    h->playerCapacity = playerCapacity;
+    h->playerSlots = playerCapacity * 2;
+    h->bestSlots = bestSlots;
+    h->recordCapacity = recordCapacity;
+    h->playerOffset = alignUp(sizeof(FileHeader));
+    h->playerIndexOffset = alignUp(h->playerOffset + (uint64_t)playerCapacity * sizeof(PlayerRecord));
+    h->bestIndexOffset = alignUp(h->playerIndexOffset + (uint64_t)h->playerSlots * sizeof(uint32_t));
+    h->topOffset = alignUp(h->bestIndexOffset + (uint64_t)bestSlots * sizeof(uint32_t));
+    h->recordOffset = alignUp(h->topOffset + (uint64_t)MAX_LEVELS * sizeof(TopTable));
+    h->fileSize = h->recordOffset + (uint64_t)recordCapacity * sizeof(ScoreRecord);
+}
+
+// Platform file mapping. mapFile maps size bytes, growing the file if it
+// is shorter; the previous mapping is only released once the new one
+// exists, so a failure leaves the board as it was.
+
+#ifdef _WIN32
+
+static bool openFile(Leaderboard *board, bool truncate) {
+    board->mapping = NULL;
+    board->file = CreateFileA(board->path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                              truncate ? CREATE_ALWAYS : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    return board->file != INVALID_HANDLE_VALUE;
+}
+
+static size_t fileSize(const Leaderboard *board) {
+    LARGE_INTEGER size;
+    return GetFileSizeEx(board->file, &size) ? (size_t)size.QuadPart : 0;
+}
+
+static void unmapFile(Leaderboard *board) {
+    if (board->base) {
+        UnmapViewOfFile(board->base);
+    }
+    if (board->mapping) {
+        CloseHandle(board->mapping);
+    }
+    board->base = NULL;
+    board->mapping = NULL;
+    board->size = 0;
+}
+
+static bool mapFile(Leaderboard *board, size_t size) {
+    // A mapping larger than the file extends it
+    HANDLE mapping = CreateFileMappingA(board->file, NULL, PAGE_READWRITE,
+                                       (DWORD)((uint64_t)size >> 32), (DWORD)size, NULL);
+    if (!mapping) {
+        return false;
+    }
+    void *base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!base) {
+        CloseHandle(mapping);
+        return false;
+    }
+    unmapFile(board);
+    board->mapping = mapping;
+    board->base = base;
+    board->size = size;
+    return true;
+}
+
+static bool flushFile(Leaderboard *board) {
+    return FlushViewOfFile(board->base, 0) && FlushFileBuffers(board->file);
+}
+
+static void closeFile(Leaderboard *board) {
+    unmapFile(board);
+    if (board->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(board->file);
+    }
+    board->file = INVALID_HANDLE_VALUE;
+}
+
+static bool replaceFile(const char *from, const char *to) {
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+}
+
+#else
+
+static bool openFile(Leaderboard *board, bool truncate) {
+    board->fd = open(board->path, O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+    return board->fd >= 0;
+}
+
+static size_t fileSize(const Leaderboard *board) {
+    struct stat st;
+    return fstat(board->fd, &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+static void unmapFile(Leaderboard *board) {
+    if (board->base) {
+        munmap(board->base, board->size);
+    }
+    board->base = NULL;
+    board->size = 0;
+}
+
+static bool mapFile(Leaderboard *board, size_t size) {
+    if (fileSize(board) < size && ftruncate(board->fd, (off_t)size) != 0) {
+        return false;
+    }
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, board->fd, 0);
+    if (base == MAP_FAILED) {
+        return false;
+    }
+    unmapFile(board);
+    board->base = base;
+    board->size = size;
+    return true;
+}
+
+static bool flushFile(Leaderboard *board) {
+    return msync(board->base, board->size, MS_SYNC) == 0;
+}
+
+static void closeFile(Leaderboard *board) {
+    unmapFile(board);
+    if (board->fd >= 0) {
+        close(board->fd);
+    }
+    board->fd = -1;
+}
+
+static bool replaceFile(const char *from, const char *to) {
+    return rename(from, to) == 0;
+}
+
+#endif
+
+static Leaderboard *newBoard(const char *path, const char *suffix) {
+    Leaderboard *board = calloc(1, sizeof(Leaderboard));
+    if (!board) {
+        return NULL;
+    }
+    size_t length = strlen(path), suffixLength = strlen(suffix);
+    board->path = malloc(length + suffixLength + 1);
+    if (!board->path) {
+        free(board);
+        return NULL;
+    }
+    memcpy(board->path, path, length);
+    memcpy(board->path + length, suffix, suffixLength + 1);
+#ifdef _WIN32
+    board->file = INVALID_HANDLE_VALUE;
+#else
+    board->fd = -1;
+#endif
+    return board;
+}
+
+static void freeBoard(Leaderboard *board) {
+    closeFile(board);
+    free(board->path);
+    free(board);
+}
+
+// FNV-1a over the padded name; never 0
+static uint32_t hashName(const char *name) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < MAX_PLAYER_NAME && name[i]; ++i) {
+        hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+static uint32_t hashPlayerLevel(uint32_t player, uint32_t level) {
+    uint32_t hash = player * 0x9E3779B1u ^ level * 0x85EBCA77u;
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    return hash ^ (hash >> 12);
+}
+
+static void copyName(char name[MAX_PLAYER_NAME], const char *player) {
+    memset(name, 0, MAX_PLAYER_NAME);
+    strncpy(name, player, MAX_PLAYER_NAME - 1);
+}
+
+// The index slot holding the player, or the empty slot it would go in.
+// Indexes are at most half full, so probing always ends.
+static uint32_t *findPlayerSlot(const Leaderboard *board, const char name[MAX_PLAYER_NAME], uint32_t hash) {
+    uint32_t *slots = playerIndex(board);
+    const PlayerRecord *list = players(board);
+    uint32_t mask = header(board)->playerSlots - 1;
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+        uint32_t entry = slots[i];
+        if (entry == 0 || (list[entry - 1].hash == hash &&
+                           memcmp(list[entry - 1].name, name, MAX_PLAYER_NAME) == 0)) {
+            return &slots[i];
+        }
+    }
+}
+
+// The slot holding a player's best record of a level, or an empty one
+static uint32_t *findBestSlot(const Leaderboard *board, uint32_t player, uint32_t level) {
+    uint32_t *slots = bestIndex(board);
+    const ScoreRecord *list = records(board);
+    uint32_t mask = header(board)->bestSlots - 1;
+    for (uint32_t i = hashPlayerLevel(player, level) & mask;; i = (i + 1) & mask) {
+        uint32_t entry = slots[i];
+        if (entry == 0 || (list[entry - 1].player == player && list[entry - 1].level == level)) {
+            return &slots[i];
+        }
+    }
+}
+
+// Binary search for the record's place in its level's top table, after
+// any equal scores, and shift the lower ones down
+static void insertTop(Leaderboard *board, uint32_t r) {
+    const ScoreRecord *list = records(board);
+    TopTable *table = &topTables(board)[list[r].level];
+    int32_t score = list[r].score;
+    uint32_t low = 0, high = table->count;
+    while (low < high) {
+        uint32_t mid = (low + high) / 2;
+        if (list[table->records[mid]].score >= score) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == LEADERBOARD_TOP) {
+        return;
+    }
+    uint32_t kept = table->count < LEADERBOARD_TOP ? table->count : LEADERBOARD_TOP - 1;
+    memmove(&table->records[low + 1], &table->records[low], (kept - low) * sizeof(uint32_t));
+    table->records[low] = r;
+    table->count = kept + 1;
+}
+
+// Link a stored record into the player's history and the indexes
+static void indexRecord(Leaderboard *board, uint32_t r) {
+    ScoreRecord *record = &records(board)[r];
+    PlayerRecord *player = &players(board)[record->player];
+    record->prevByPlayer = player->lastRecord;
+    player->lastRecord = r + 1;
+    player->numRecords++;
+
+    uint32_t *slot = findBestSlot(board, record->player, record->level);
+    if (*slot == 0) {
+        *slot = r + 1;
+        header(board)->numBest++;
+    } else if (record->score > records(board)[*slot - 1].score) {
+        *slot = r + 1;
+    }
+    insertTop(board, r);
+}
+
+// Recreate the indexes from the players and records, after a crash or
+// when moving to a bigger layout. A record torn by a crash ends the list.
+// False if the records need a bigger best-score index than the layout has;
+// nothing is dropped then and the caller moves to a bigger layout.
+static bool rebuildIndexes(Leaderboard *board) {
+    FileHeader *h = header(board);
+    memset(playerIndex(board), 0, (size_t)h->playerSlots * sizeof(uint32_t));
+    memset(bestIndex(board), 0, (size_t)h->bestSlots * sizeof(uint32_t));
+    memset(topTables(board), 0, MAX_LEVELS * sizeof(TopTable));
+    h->numBest = 0;
+
+    PlayerRecord *list = players(board);
+    for (uint32_t p = 0; p < h->numPlayers; ++p) {
+        list[p].name[MAX_PLAYER_NAME - 1] = '\0';
+        list[p].hash = hashName(list[p].name);
+        list[p].numRecords = 0;
+        list[p].lastRecord = 0;
+        uint32_t *slot = findPlayerSlot(board, list[p].name, list[p].hash);
+        if (*slot == 0) {
+            *slot = p + 1;
+        }
+    }
+    for (uint32_t r = 0; r < h->numRecords; ++r) {
+        const ScoreRecord *record = &records(board)[r];
+        if (record->player >= h->numPlayers || record->level >= MAX_LEVELS) {
+            h->numRecords = r;
+            break;
+        }
+        if ((h->numBest + 1) * 2 > h->bestSlots && *findBestSlot(board, record->player, record->level) == 0) {
+            return false;
+        }
+        indexRecord(board, r);
+    }
+    return true;
+}
+
+// Whether everything the indexes point at is in range, so lookups stay
+// inside the file and every hash probe meets an empty slot. Only the
+// indexes are read, not the history; records reached through a player's
+// history are checked as they are walked.
+static bool validIndexes(const Leaderboard *board) {
+    const FileHeader *h = header(board);
+    const PlayerRecord *playerList = players(board);
+    const ScoreRecord *recordList = records(board);
+    if ((uint64_t)h->numBest * 2 > h->bestSlots) {
+        return false;
+    }
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < h->playerSlots; ++i) {
+        uint32_t entry = playerIndex(board)[i];
+        if (entry > h->numPlayers) {
+            return false;
+        }
+        used += entry != 0;
+    }
+    if (used > h->numPlayers) {
+        return false;
+    }
+    for (uint32_t p = 0; p < h->numPlayers; ++p) {
+        if (playerList[p].lastRecord > h->numRecords) {
+            return false;
+        }
+    }
+    used = 0;
+    for (uint32_t i = 0; i < h->bestSlots; ++i) {
+        uint32_t entry = bestIndex(board)[i];
+        if (entry > h->numRecords ||
+            (entry != 0 && (recordList[entry - 1].player >= h->numPlayers || recordList[entry - 1].level >= MAX_LEVELS))) {
+            return false;
+        }
+        used += entry != 0;
+    }
+    if (used != h->numBest) {
+        return false;
+    }
+    for (int level = 0; level < MAX_LEVELS; ++level) {
+        const TopTable *table = &topTables(board)[level];
+        if (table->count > LEADERBOARD_TOP) {
+            return false;
+        }
+        for (uint32_t n = 0; n < table->count; ++n) {
+            uint32_t r = table->records[n];
+            if (r >= h->numRecords || recordList[r].player >= h->numPlayers) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Size a new, empty file and write its header
+static bool createLayout(Leaderboard *board, uint32_t playerCapacity, uint32_t bestSlots, uint32_t recordCapacity) {
+    FileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, LEADERBOARD_MAGIC, sizeof(h.magic));
+    h.version = LEADERBOARD_VERSION;
+    h.byteOrder = BYTE_ORDER_MARK;
+    layoutHeader(&h, playerCapacity, bestSlots, recordCapacity);
+    if (!mapFile(board, (size_t)h.fileSize)) {
+        return false;
+    }
+    *header(board) = h;  // The rest of a new file reads as zeros
+    return true;
+}
+
+static bool isPowerOfTwo(uint32_t n) {
+    return n && !(n & (n - 1));
+}
+
+static bool validHeader(const FileHeader *h, size_t size) {
+    if (size < sizeof(FileHeader) || memcmp(h->magic, LEADERBOARD_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != LEADERBOARD_VERSION || h->byteOrder != BYTE_ORDER_MARK ||
+        !isPowerOfTwo(h->playerCapacity) || !isPowerOfTwo(h->bestSlots) ||
+        h->numPlayers > h->playerCapacity || h->numRecords > h->recordCapacity) {
+        return false;
+    }
+    FileHeader expected = *h;
+    layoutHeader(&expected, h->playerCapacity, h->bestSlots, h->recordCapacity);
+    return memcmp(&expected, h, sizeof(FileHeader)) == 0 && h->fileSize <= size;
+}
+
+static bool relayout(Leaderboard *board, uint32_t playerCapacity, uint32_t bestSlots);
+
+Leaderboard *openLeaderboard(const char *path) {
+    Leaderboard *board = newBoard(path, "");
+    if (!board) {
+        printf("Failed to allocate leaderboard!\n");
+        return NULL;
+    }
+    if (!openFile(board, false)) {
+        printf("Failed to open %s!\n", path);
+        freeBoard(board);
+        return NULL;
+    }
+    size_t size = fileSize(board);
+    if (size == 0) {
+        if (!createLayout(board, INITIAL_PLAYERS, INITIAL_BEST_SLOTS, INITIAL_RECORDS)) {
+            printf("Failed to create %s!\n", path);
+            freeBoard(board);
+            return NULL;
+        }
+    } else if (!mapFile(board, size) || !validHeader(header(board), size)) {
+        printf("%s is not a leaderboard file!\n", path);
+        freeBoard(board);
+        return NULL;
+    }
+
+    // A crash mid-insert leaves the flag set. A clean file still has its
+    // indexes checked, which is cheap next to reading the whole history.
+    bool rebuild = header(board)->dirty != 0;
+    if (rebuild) {
+        printf("%s was not closed cleanly, rebuilding its indexes\n", path);
+    } else if (!validIndexes(board)) {
+        printf("%s has damaged indexes, rebuilding them\n", path);
+        rebuild = true;
+    }
+    if (rebuild) {
+        FileHeader *h = header(board);
+        if (!rebuildIndexes(board) && !relayout(board, h->playerCapacity, h->bestSlots)) {
+            printf("Failed to rebuild %s!\n", path);
+            freeBoard(board);
+            return NULL;
+        }
+        header(board)->dirty = 0;
+        flushFile(board);
+    }
+    return board;
+}
+
+void closeLeaderboard(Leaderboard *board) {
+    if (!board) {
+        return;
+    }
+    if (board->base) {
+        flushFile(board);
+    }
+    freeBoard(board);
+}
+
+bool syncLeaderboard(Leaderboard *board) {
+    return board->base && flushFile(board);
+}
+
+// Double the record capacity; records are the last section, so the
+// mapping just gets longer
+static bool growRecords(Leaderboard *board) {
+    FileHeader *h = header(board);
+    if (h->recordCapacity > UINT32_MAX / 2) {
+        return false;
+    }
+    uint32_t capacity = h->recordCapacity * 2;
+    uint64_t size = h->recordOffset + (uint64_t)capacity * sizeof(ScoreRecord);
+    if (!mapFile(board, (size_t)size)) {
+        printf("Failed to grow %s!\n", board->path);
+        return false;
+    }
+    header(board)->recordCapacity = capacity;
+    header(board)->fileSize = size;
+    return true;
+}
+
+// Move to bigger player or best-score indexes: build the new layout in
+// path.tmp and rename it over the file, so a crash leaves one of the two
+// complete files
+static bool relayout(Leaderboard *board, uint32_t playerCapacity, uint32_t bestSlots) {
+    Leaderboard *copy = newBoard(board->path, ".tmp");
+    if (!copy) {
+        return false;
+    }
+    const FileHeader *old = header(board);
+    bool ok = openFile(copy, true);
+    bool fits = false;
+    while (ok && !fits) {
+        ok = createLayout(copy, playerCapacity, bestSlots, old->recordCapacity);
+        if (ok) {
+            FileHeader *h = header(copy);
+            h->numPlayers = old->numPlayers;
+            h->numRecords = old->numRecords;
+            memcpy(players(copy), players(board), (size_t)old->numPlayers * sizeof(PlayerRecord));
+            memcpy(records(copy), records(board), (size_t)old->numRecords * sizeof(ScoreRecord));
+            // The history may hold more best records than the old index
+            // did (it was rebuilt after a crash); widen until they fit
+            fits = rebuildIndexes(copy);
+            if (!fits) {
+                ok = bestSlots <= UINT32_MAX / 2;
+                bestSlots *= 2;
+            }
+        }
+    }
+    if (ok) {
+        ok = flushFile(copy);
+    }
+    closeFile(copy);
+    if (!ok) {
+        printf("Failed to write %s!\n", copy->path);
+        remove(copy->path);
+        freeBoard(copy);
+        return false;
+    }
+
+    // Files cannot be replaced while open everywhere, so let go of the old
+    // one first and map whichever file is in place afterwards
+    flushFile(board);
+    closeFile(board);
+    ok = replaceFile(copy->path, board->path);
+    if (!ok) {
+        printf("Failed to replace %s!\n", board->path);
+        remove(copy->path);
+    }
+    freeBoard(copy);
+    if (!openFile(board, false) || !mapFile(board, fileSize(board))) {
+        printf("Failed to reopen %s!\n", board->path);
+        closeFile(board);
+        return false;
+    }
+    return ok;
+}
+
+bool addScore(Leaderboard *board, const char *player, int level, int score, int64_t time) {
+    if (!board->base || level < 0 || level >= MAX_LEVELS) {
+        return false;
+    }
+    char name[MAX_PLAYER_NAME];
+    copyName(name, player);
+    uint32_t hash = hashName(name);
+
+    // Make room first; each step may move the mapping
+    FileHeader *h = header(board);
+    bool newPlayer = *findPlayerSlot(board, name, hash) == 0;
+    if ((newPlayer && h->numPlayers == h->playerCapacity) || (h->numBest + 1) * 2 > h->bestSlots) {
+        uint32_t playerCapacity = h->playerCapacity, bestSlots = h->bestSlots;
+        if (newPlayer && h->numPlayers == h->playerCapacity) {
+            playerCapacity *= 2;
+        }
+        if ((h->numBest + 1) * 2 > h->bestSlots) {
+            bestSlots *= 2;
+        }
+        if (!relayout(board, playerCapacity, bestSlots)) {
+            return false;
+        }
+    }
+    if (header(board)->numRecords == header(board)->recordCapacity && !growRecords(board)) {
+        return false;
+    }
+    h = header(board);
+
+    // Data before counts, counts before indexes: a crash at any point
+    // leaves something rebuildIndexes can recover, and the flag says so
+    h->dirty = 1;
+    uint32_t *slot = findPlayerSlot(board, name, hash);
+    uint32_t p;
+    if (*slot == 0) {
+        p = h->numPlayers;
+        PlayerRecord *entry = &players(board)[p];
+        memset(entry, 0, sizeof(*entry));
+        memcpy(entry->name, name, MAX_PLAYER_NAME);
+        entry->hash = hash;
+        h->numPlayers = p + 1;
+        *slot = p + 1;
+    } else {
+        p = *slot - 1;
+    }
+    uint32_t r = h->numRecords;
+    ScoreRecord *record = &records(board)[r];
+    record->player = p;
+    record->level = (uint32_t)level;
+    record->score = score;
+    record->prevByPlayer = 0;
+    record->time = time;
+    h->numRecords = r + 1;
+    indexRecord(board, r);
+    h->dirty = 0;
+    return true;
+}
+
+static void toEntry(const Leaderboard *board, uint32_t r, ScoreEntry *out) {
+    const ScoreRecord *record = &records(board)[r];
+    memcpy(out->player, players(board)[record->player].name, MAX_PLAYER_NAME);
+    out->level = (int)record->level;
+    out->score = record->score;
+    out->time = record->time;
+}
+
+int leaderboardBest(const Leaderboard *board, int level) {
+    if (!board->base || level < 0 || level >= MAX_LEVELS) {
+        return 0;
+    }
+    const TopTable *table = &topTables(board)[level];
+    return table->count ? records(board)[table->records[0]].score : 0;
+}
+
+int topScores(const Leaderboard *board, int level, ScoreEntry *out, int maxOut) {
+    if (!board->base || level < 0 || level >= MAX_LEVELS) {
+        return 0;
+    }
+    const TopTable *table = &topTables(board)[level];
+    int n = 0;
+    for (; n < maxOut && n < (int)table->count; ++n) {
+        toEntry(board, table->records[n], &out[n]);
+    }
+    return n;
+}
+
+bool playerBest(const Leaderboard *board, const char *player, int level, ScoreEntry *out) {
+    if (!board->base || level < 0 || level >= MAX_LEVELS) {
+        return false;
+    }
+    char name[MAX_PLAYER_NAME];
+    copyName(name, player);
+    uint32_t p = *findPlayerSlot(board, name, hashName(name));
+    if (p == 0) {
+        return false;
+    }
+    uint32_t r = *findBestSlot(board, p - 1, (uint32_t)level);
+    if (r == 0) {
+        return false;
+    }
+    toEntry(board, r - 1, out);
+    return true;
+}
+
+int playerHistory(const Leaderboard *board, const char *player, ScoreEntry *out, int maxOut) {
+    if (!board->base) {
+        return 0;
+    }
+    char name[MAX_PLAYER_NAME];
+    copyName(name, player);
+    uint32_t p = *findPlayerSlot(board, name, hashName(name));
+    if (p == 0) {
+        return 0;
+    }
+    // The history is not checked on open: each link must go back to an
+    // earlier record of the same player
+    int n = 0;
+    uint32_t limit = header(board)->numRecords + 1;
+    for (uint32_t r = players(board)[p - 1].lastRecord; r && r < limit && n < maxOut;
+         r = records(board)[r - 1].prevByPlayer) {
+        if (records(board)[r - 1].player != p - 1) {
+            break;
+        }
+        toEntry(board, r - 1, &out[n++]);
+        limit = r;
+    }
+    return n;
+}
+
+uint32_t leaderboardSize(const Leaderboard *board) {
+    return board->base ? header(board)->numRecords : 0;
+}
+
+bool importLegacyScores(Leaderboard *board, const char *path, const char *player) {
+    if (!board->base || header(board)->numRecords > 0) {
+        return false;
+    }
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    bool imported = false;
+    char line[1024];
+    if (fgets(line, sizeof(line), file)) {
+        int score = atoi(line); // Convert string to integer
+        imported = score > 0 && addScore(board, player, 0, score, (int64_t)time(NULL));
+    }
+    fclose(file);
+    if (imported) {
+        printf("Imported best score from %s\n", path);
+    }
+    return imported;
+}
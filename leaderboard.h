@@ -0,0 +1,64 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Persistent leaderboard: every finished game of every player, in one
+// memory-mapped binary file. Besides the records themselves the file holds
+// a hash index from player name to player, a hash index of each player's
+// best record per level and a sorted top table per level, so opening the
+// file, inserts and lookups never read the whole history.
+//
+// The file is native endian and is only read back by the machine that
+// wrote it. Not thread safe: one thread uses a board at a time.
+
+#define MAX_LEVELS 256
+#define LEADERBOARD_TOP 100   // Records kept in each level's top table
+#define MAX_PLAYER_NAME 32    // Including the terminating zero
+
+typedef struct Leaderboard Leaderboard;
+
+// A record as returned by queries
+typedef struct {
+    char player[MAX_PLAYER_NAME];
+    int level;
+    int score;
+    int64_t time;  // Seconds since the epoch
+} ScoreEntry;
+
+// Open or create the file; NULL (with a message) if it cannot be mapped or
+// is not a leaderboard
+Leaderboard *openLeaderboard(const char *path);
+
+// Write everything back and unmap the file
+void closeLeaderboard(Leaderboard *board);
+
+// Flush changes to disk
+bool syncLeaderboard(Leaderboard *board);
+
+// Add one finished game; names longer than MAX_PLAYER_NAME - 1 are cut
+bool addScore(Leaderboard *board, const char *player, int level, int score, int64_t time);
+
+// Best score of a level, or 0 if it has none
+int leaderboardBest(const Leaderboard *board, int level);
+
+// Up to maxOut best records of a level, highest first; equal scores keep
+// the order they were set in
+int topScores(const Leaderboard *board, int level, ScoreEntry *out, int maxOut);
+
+// A player's best record of a level; false if they have not played it
+bool playerBest(const Leaderboard *board, const char *player, int level, ScoreEntry *out);
+
+// A player's up to maxOut most recent records, newest first
+int playerHistory(const Leaderboard *board, const char *player, ScoreEntry *out, int maxOut);
+
+// Records stored
+uint32_t leaderboardSize(const Leaderboard *board);
+
+// Bring the single best score of an old scores.txt in as player's level 0
+// record. Only done while the board is still empty; false if there was
+// nothing to import.
+bool importLegacyScores(Leaderboard *board, const char *path, const char *player);
+
+#endif
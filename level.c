@@ -0,0 +1,379 @@
+#include "level.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char LEVEL_MAGIC[4] = { 'B', 'R', 'K', 'V' };
+static const uint32_t LEVEL_VERSION = 3;
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// Sections start on cache lines, so SIMD loads never straddle two of them
+static const uint64_t SECTION_ALIGNMENT = 64;
+
+// Default brick colour, as the game draws the built-in level
+static const uint32_t DEFAULT_COLOR = 0xFF0000FF;
+
+// File layout: header, then one array per field (x, y, width, height as
+// int32, cells as uint8, colours as uint32), each `capacity` entries long
+// and at an offset stored in the header. A lattice level has no x, y,
+// width and height arrays; their offsets are 0.
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t count;
+    uint32_t capacity;  // count rounded up to BRICK_BLOCK
+    uint32_t id;        // Leaderboard level, 0 for none
+    uint64_t xOffset, yOffset, widthOffset, heightOffset;
+    uint64_t cellOffset, colorOffset;
+    uint64_t fileSize;
+    int32_t cols;  // Lattice columns, 0 for explicit geometry
+    int32_t originX, originY, pitchX, pitchY, brickWidth, brickHeight;
+} LevelHeader;
+
+struct Level {
+    const uint8_t *base;
+    size_t size;
+    bool oneHit;      // Every brick is normal and breaks on its first hit
+    int unbreakable;  // Bricks of type BRICK_UNBREAKABLE
+};
+
+static uint64_t alignSection(uint64_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+}
+
+static uint32_t levelCapacity(uint32_t count) {
+    uint32_t capacity = (count + BRICK_BLOCK - 1) / BRICK_BLOCK * BRICK_BLOCK;
+    return capacity > 0 ? capacity : BRICK_BLOCK;
+}
+
+// Place the sections for count bricks, on lattice if it is not NULL
+static void layoutLevel(LevelHeader *h, uint32_t count, const BrickLattice *lattice) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, LEVEL_MAGIC, 4);
+    h->version = LEVEL_VERSION;
+    h->byteOrder = BYTE_ORDER_MARK;
+    h->count = count;
+    h->capacity = levelCapacity(count);
+    uint64_t capacity = h->capacity;
+    if (lattice) {
+        h->cols = lattice->cols;
+        h->originX = lattice->originX;
+        h->originY = lattice->originY;
+        h->pitchX = lattice->pitchX;
+        h->pitchY = lattice->pitchY;
+        h->brickWidth = lattice->width;
+        h->brickHeight = lattice->height;
+        h->cellOffset = alignSection(sizeof(LevelHeader));
+    } else {
+        h->xOffset = alignSection(sizeof(LevelHeader));
+        h->yOffset = alignSection(h->xOffset + capacity * sizeof(int32_t));
+        h->widthOffset = alignSection(h->yOffset + capacity * sizeof(int32_t));
+        h->heightOffset = alignSection(h->widthOffset + capacity * sizeof(int32_t));
+        h->cellOffset = alignSection(h->heightOffset + capacity * sizeof(int32_t));
+    }
+    h->colorOffset = alignSection(h->cellOffset + capacity * sizeof(uint8_t));
+    h->fileSize = h->colorOffset + capacity * sizeof(uint32_t);
+}
+
+// Platform file mapping; the file can be closed once it is mapped
+
+#ifdef _WIN32
+
+static bool mapLevel(Level *level, const char *path) {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+    if (mapping) {
+        level->base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        level->size = (size_t)size.QuadPart;
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    return level->base != NULL;
+}
+
+static void unmapLevel(Level *level) {
+    UnmapViewOfFile(level->base);
+}
+
+static bool replaceFile(const char *from, const char *to) {
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING);
+}
+
+#else
+
+static bool mapLevel(Level *level, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    void *base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) {
+        return false;
+    }
+    // Start reading ahead; the game touches the arrays front to back
+    posix_madvise(base, (size_t)st.st_size, POSIX_MADV_WILLNEED);
+    level->base = base;
+    level->size = (size_t)st.st_size;
+    return true;
+}
+
+static void unmapLevel(Level *level) {
+    munmap((void *)level->base, level->size);
+}
+
+static bool replaceFile(const char *from, const char *to) {
+    return rename(from, to) == 0;
+}
+
+#endif
+
+// A section of capacity entries must lie inside the file, aligned
+static bool validSection(const LevelHeader *h, uint64_t offset, size_t entrySize, size_t fileSize) {
+    return offset % SECTION_ALIGNMENT == 0 && offset >= sizeof(LevelHeader) &&
+           offset <= fileSize && (fileSize - offset) / entrySize >= h->capacity;
+}
+
+// Every lattice brick must lie within the world bounds, like explicit
+// ones, and bricks must not overlap. Works in 64 bits, so no field can
+// overflow the checks.
+static bool validLattice(const LevelHeader *h) {
+    int64_t rows = h->count > 0 ? ((int64_t)h->count + h->cols - 1) / h->cols : 1;
+    return h->cols >= 1 && h->pitchX >= 1 && h->pitchX <= MAX_LEVEL_COORD && h->pitchY >= 1 &&
+           h->pitchY <= MAX_LEVEL_COORD && h->brickWidth >= 1 && h->brickWidth <= h->pitchX &&
+           h->brickHeight >= 1 && h->brickHeight <= h->pitchY &&
+           h->originX >= -MAX_LEVEL_COORD && h->originY >= -MAX_LEVEL_COORD &&
+           h->originX + (int64_t)(h->cols - 1) * h->pitchX <= MAX_LEVEL_COORD &&
+           h->originY + (rows - 1) * h->pitchY <= MAX_LEVEL_COORD;
+}
+
+static bool validHeader(const LevelHeader *h, size_t fileSize) {
+    bool geometry = h->cols == 0 ?
+        validSection(h, h->xOffset, sizeof(int32_t), fileSize) &&
+        validSection(h, h->yOffset, sizeof(int32_t), fileSize) &&
+        validSection(h, h->widthOffset, sizeof(int32_t), fileSize) &&
+        validSection(h, h->heightOffset, sizeof(int32_t), fileSize) :
+        validLattice(h) && (h->xOffset | h->yOffset | h->widthOffset | h->heightOffset) == 0;
+    return memcmp(h->magic, LEVEL_MAGIC, 4) == 0 && h->version == LEVEL_VERSION &&
+           h->byteOrder == BYTE_ORDER_MARK && h->count <= MAX_LEVEL_BRICKS && h->id <= MAX_LEVEL_ID &&
+           h->capacity == levelCapacity(h->count) && geometry &&
+           validSection(h, h->cellOffset, sizeof(uint8_t), fileSize) &&
+           validSection(h, h->colorOffset, sizeof(uint32_t), fileSize);
+}
+
+static const LevelHeader *levelHeader(const Level *level) {
+    return (const LevelHeader *)level->base;
+}
+
+// Every brick must have a size and lie within the world bounds; a corrupt
+// file must not make the game build a huge collision grid. Also notes
+// whether the cells need to be kept at all. Lattice bounds are checked
+// with the header.
+static bool validBricks(Level *level) {
+    const LevelHeader *h = levelHeader(level);
+    const int32_t *x = NULL, *y = NULL, *width = NULL, *height = NULL;
+    if (h->cols == 0) {
+        x = (const int32_t *)(level->base + h->xOffset);
+        y = (const int32_t *)(level->base + h->yOffset);
+        width = (const int32_t *)(level->base + h->widthOffset);
+        height = (const int32_t *)(level->base + h->heightOffset);
+    }
+    const uint8_t *cells = level->base + h->cellOffset;
+    const uint8_t oneHit = brickCell(BRICK_NORMAL, 1);
+    level->oneHit = true;
+    level->unbreakable = 0;
+    for (uint32_t i = 0; i < h->count; ++i) {
+        if (h->cols == 0 &&
+            (x[i] < -MAX_LEVEL_COORD || x[i] > MAX_LEVEL_COORD || y[i] < -MAX_LEVEL_COORD ||
+             y[i] > MAX_LEVEL_COORD || width[i] < 1 || width[i] > MAX_LEVEL_COORD ||
+             height[i] < 1 || height[i] > MAX_LEVEL_COORD)) {
+            return false;
+        }
+        if (cellType(cells[i]) > BRICK_UNBREAKABLE || cellHits(cells[i]) < 1) {
+            return false;
+        }
+        level->oneHit &= cells[i] == oneHit;
+        level->unbreakable += cellType(cells[i]) == BRICK_UNBREAKABLE;
+    }
+    return true;
+}
+
+Level *openLevel(const char *path) {
+    Level *level = calloc(1, sizeof(Level));
+    if (!level) {
+        printf("Failed to allocate level!\n");
+        return NULL;
+    }
+    if (!mapLevel(level, path)) {
+        printf("Failed to open level %s!\n", path);
+        free(level);
+        return NULL;
+    }
+    if (level->size < sizeof(LevelHeader) || !validHeader(levelHeader(level), level->size)) {
+        printf("Invalid or unsupported level file %s!\n", path);
+        closeLevel(level);
+        return NULL;
+    }
+    if (!validBricks(level)) {
+        printf("Level file %s has bricks out of bounds or with invalid hits!\n", path);
+        closeLevel(level);
+        return NULL;
+    }
+    return level;
+}
+
+void closeLevel(Level *level) {
+    if (!level) {
+        return;
+    }
+    unmapLevel(level);
+    free(level);
+}
+
+int levelBrickCount(const Level *level) {
+    return (int)levelHeader(level)->count;
+}
+
+int levelId(const Level *level) {
+    return (int)levelHeader(level)->id;
+}
+
+bool initLevelBricks(const Level *level, BrickStore *store) {
+    const LevelHeader *h = levelHeader(level);
+    const uint8_t *base = level->base;
+    if (h->cols > 0) {
+        BrickLattice lattice = {
+            h->cols, h->originX, h->originY, h->pitchX, h->pitchY, h->brickWidth, h->brickHeight
+        };
+        if (!initBrickLattice(store, (int)h->count, &lattice)) {
+            return false;
+        }
+    } else if (!initBrickStoreView(store, (int)h->count, (const int32_t *)(base + h->xOffset),
+                                   (const int32_t *)(base + h->yOffset), (const int32_t *)(base + h->widthOffset),
+                                   (const int32_t *)(base + h->heightOffset))) {
+        return false;
+    }
+    store->colors = (const uint32_t *)(base + h->colorOffset);
+    if (!level->oneHit && !initBrickCells(store, base + h->cellOffset, level->unbreakable)) {
+        freeBrickStore(store);
+        return false;
+    }
+    return true;
+}
+
+// Write count entries of data (or of fill when data is NULL), then zeros
+// up to end, the next section's offset. position tracks the file offset.
+static bool writeSection(FILE *file, uint64_t *position, const void *data, const void *fill,
+                         size_t entrySize, uint64_t count, uint64_t end) {
+    static const uint8_t zeros[4096];
+    if (data) {
+        if (fwrite(data, entrySize, count, file) != count) {
+            return false;
+        }
+    } else if (count > 0) {
+        uint8_t block[4096];
+        size_t perBlock = sizeof(block) / entrySize;
+        for (size_t e = 0; e < perBlock; ++e) {
+            memcpy(&block[e * entrySize], fill, entrySize);
+        }
+        for (uint64_t done = 0; done < count;) {
+            size_t n = count - done < perBlock ? (size_t)(count - done) : perBlock;
+            if (fwrite(block, entrySize, n, file) != n) {
+                return false;
+            }
+            done += n;
+        }
+    }
+    *position += count * entrySize;
+    while (*position < end) {
+        size_t n = end - *position < sizeof(zeros) ? (size_t)(end - *position) : sizeof(zeros);
+        if (fwrite(zeros, 1, n, file) != n) {
+            return false;
+        }
+        *position += n;
+    }
+    return *position == end;
+}
+
+bool saveLevel(const char *path, const LevelData *data) {
+    if (data->count < 0 || data->count > MAX_LEVEL_BRICKS) {
+        printf("A level holds at most %d bricks!\n", MAX_LEVEL_BRICKS);
+        return false;
+    }
+    if (data->id < 0 || data->id > MAX_LEVEL_ID) {
+        printf("Level ids go from 1 to %d, or 0 for none!\n", MAX_LEVEL_ID);
+        return false;
+    }
+    LevelHeader h;
+    layoutLevel(&h, (uint32_t)data->count, data->lattice);
+    h.id = (uint32_t)data->id;
+    if (data->lattice && !validLattice(&h)) {
+        printf("Level lattice bricks must not overlap and must lie within %d pixels!\n", MAX_LEVEL_COORD);
+        return false;
+    }
+
+    // Write next to the target and swap it in, so a game that has the old
+    // file mapped keeps a consistent copy
+    size_t pathLength = strlen(path);
+    char *tempPath = malloc(pathLength + 5);
+    if (!tempPath) {
+        printf("Failed to allocate level path!\n");
+        return false;
+    }
+    memcpy(tempPath, path, pathLength);
+    memcpy(tempPath + pathLength, ".tmp", 5);
+    FILE *file = fopen(tempPath, "wb");
+    if (!file) {
+        printf("Failed to open level file %s for writing!\n", tempPath);
+        free(tempPath);
+        return false;
+    }
+
+    const uint8_t oneHit = brickCell(BRICK_NORMAL, 1);
+    uint64_t count = h.count;
+    uint64_t position = sizeof(h);
+    bool ok = fwrite(&h, sizeof(h), 1, file) == 1;
+    if (ok && !data->lattice) {
+        ok = writeSection(file, &position, NULL, NULL, 1, 0, h.xOffset) &&
+             writeSection(file, &position, data->x, NULL, sizeof(int32_t), count, h.yOffset) &&
+             writeSection(file, &position, data->y, NULL, sizeof(int32_t), count, h.widthOffset) &&
+             writeSection(file, &position, data->width, NULL, sizeof(int32_t), count, h.heightOffset) &&
+             writeSection(file, &position, data->height, NULL, sizeof(int32_t), count, h.cellOffset);
+    }
+    ok = ok && writeSection(file, &position, NULL, NULL, 1, 0, h.cellOffset) &&
+              writeSection(file, &position, data->cells, &oneHit, sizeof(uint8_t), count, h.colorOffset) &&
+              writeSection(file, &position, data->colors, &DEFAULT_COLOR, sizeof(uint32_t), count, h.fileSize);
+    ok = fclose(file) == 0 && ok;
+    if (ok && !replaceFile(tempPath, path)) {
+        ok = false;
+    }
+    if (!ok) {
+        printf("Failed to write level file %s!\n", path);
+        remove(tempPath);
+    }
+    free(tempPath);
+    return ok;
+}
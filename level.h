@@ -0,0 +1,58 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bricks.h"
+
+// Binary level files. Each brick field is stored as its own array, padded
+// to a multiple of BRICK_BLOCK bricks and 64-byte aligned, so a mapped
+// file is used in place as a BrickStore's arrays without parsing. Opening
+// a level maps it and checks the header and the brick bounds in one
+// sequential pass, which also reads the pages in. A regular layout is
+// stored as a lattice instead, with no geometry arrays at all.
+typedef struct Level Level;
+
+// Bricks to write to a level file, arrays of count entries. NULL cells or
+// colors mean normal one-hit bricks and red.
+typedef struct {
+    int count;
+    const int32_t *x, *y, *width, *height;  // Unused with a lattice
+    const uint8_t *cells;           // brickCell(type, hits), hits 1 to MAX_BRICK_HITS
+    const uint32_t *colors;         // 0xRRGGBBAA
+    int id;                         // See levelId
+    const BrickLattice *lattice;    // Non-NULL: the bricks' geometry
+} LevelData;
+
+// Bricks in one level file, so that indices fit an int with room to spare
+#define MAX_LEVEL_BRICKS (1 << 28)
+
+// Leaderboard levels a file may be scored as. Level 0 is the built-in
+// level, so a file with id 0 has none and its games are not scored.
+#define MAX_LEVEL_ID 255
+
+// Brick coordinates and sizes a level may use, in pixels; sizes are at
+// least 1. Keeps every brick edge well inside int range.
+#define MAX_LEVEL_COORD (1 << 24)
+
+// NULL (with a message) if the file is missing or not a valid level,
+// including bricks outside MAX_LEVEL_COORD or with invalid cells
+Level *openLevel(const char *path);
+void closeLevel(Level *level);
+
+int levelBrickCount(const Level *level);
+
+// The leaderboard level the file's games count for, 1 to MAX_LEVEL_ID, or
+// 0 if they are not scored
+int levelId(const Level *level);
+
+// Point store at the level's arrays (or lattice) with every brick standing.
+// Only the active mask is allocated, and the cells if any brick takes more
+// than one hit; the level must stay open while store is used.
+bool initLevelBricks(const Level *level, BrickStore *store);
+
+// Write a level file; false (with a message) on failure
+bool saveLevel(const char *path, const LevelData *data);
+
+#endif
@@ -3,162 +3,105 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
-// Screen dimension constants
-const int SCREEN_WIDTH = 880;
-const int SCREEN_HEIGHT = 800;
-
-// Game element dimensions
-const int PADDLE_WIDTH = 400;
-const int PADDLE_HEIGHT = 20;
-const int BALL_SIZE = 15;
-const int BRICK_WIDTH = 80;
-const int BRICK_HEIGHT = 30;
-const int NUM_BRICKS = 20;
-
-// Paddle movement speed
-const int PADDLE_SPEED = 20;
-
-// Structures for game elements
-typedef struct {
-    float x, y;
-    float width, height;
-} Paddle;
-
-typedef struct {
-    float x, y;
-    float dx, dy;
-    float size;
-} Ball;
-
-typedef struct {
-    int x, y;
-    int width, height;
-    bool active;
-} Brick;
-
-bool gameOver = false;
-int score = 0;
-
-// Function to get the best score from the file
-int getBestScore() {
-    int bestScore = 0;
-    FILE *file = fopen("scores.txt", "r");
-    if (file) {
-        char line[1024];
-        if (fgets(line, sizeof(line), file)) {
-            bestScore = atoi(line); // Convert string to integer
-        }
-        fclose(file);
-    }
-    return bestScore;
-}
+#include "game.h"
+#include "pacing.h"
+#include "particles.h"
+#include "profiler.h"
+#include "render.h"
+#include "scores.h"
+#include "simulation.h"
+#include "text.h"
 
-// Function to update the best score in the file
-void updateBestScore(int score) {
-    FILE *file = fopen("scores.txt", "w");
-    if (file) {
-        fprintf(file, "%d\n", score);
-        fclose(file);
-    }
-}
-
-// Initialize game elements
-void initPaddle(Paddle *paddle) {
-    paddle->width = PADDLE_WIDTH;
-    paddle->height = PADDLE_HEIGHT;
-    paddle->x = (SCREEN_WIDTH - PADDLE_WIDTH) / 2;
-    paddle->y = SCREEN_HEIGHT - PADDLE_HEIGHT - 10;
-}
+static const SDL_Color WHITE = {255, 255, 255, 255};
+static const SDL_Color RED = {255, 0, 0, 255};
 
-void initBall(Ball *ball) {
-    ball->size = BALL_SIZE;
-    ball->x = SCREEN_WIDTH / 2;
-    ball->y = SCREEN_HEIGHT - PADDLE_HEIGHT - BALL_SIZE - 20;
-    ball->dx = 10.f; // Horizontal speed
-    ball->dy = -10.f; // Vertical speed
-}
+// Debris particles alive at once, before the adaptive limit cuts in
+static const int MAX_PARTICLES = 1 << 18;
 
-void initBricks(Brick bricks[]) {
-    for (int i = 0; i < NUM_BRICKS; ++i) {
-        bricks[i].width = BRICK_WIDTH;
-        bricks[i].height = BRICK_HEIGHT;
-        bricks[i].x = (i % 10) * (BRICK_WIDTH + 5) + 15;
-        bricks[i].y = (i / 10) * (BRICK_HEIGHT + 5) + 15;
-        bricks[i].active = true;
-    }
+float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
 }
 
-// Function to draw paddle
-void drawPaddle(SDL_Renderer *renderer, Paddle *paddle) {
-    SDL_Rect rect = { (int)paddle->x, (int)paddle->y, (int)paddle->width, (int)paddle->height };
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White
-    SDL_RenderFillRect(renderer, &rect);
+// Blend the positions before and after the last physics step for rendering
+Paddle interpolatePaddle(const Paddle *current, float alpha) {
+    Paddle paddle = *current;
+    paddle.x = lerp(current->prevX, current->x, alpha);
+    paddle.y = lerp(current->prevY, current->y, alpha);
+    return paddle;
 }
 
-// Function to draw ball
-void drawBall(SDL_Renderer *renderer, Ball *ball) {
-    SDL_Rect rect = { (int)(ball->x - ball->size / 2), (int)(ball->y - ball->size / 2), (int)ball->size, (int)ball->size };
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White
-    SDL_RenderFillRect(renderer, &rect);
+Ball interpolateBall(const Ball *current, float alpha) {
+    Ball ball = *current;
+    ball.x = lerp(current->prevX, current->x, alpha);
+    ball.y = lerp(current->prevY, current->y, alpha);
+    return ball;
 }
 
-// Function to draw bricks
-void drawBricks(SDL_Renderer *renderer, Brick bricks[]) {
-    for (int i = 0; i < NUM_BRICKS; ++i) {
-        if (bricks[i].active) {
-            SDL_Rect rect = { bricks[i].x, bricks[i].y, bricks[i].width, bricks[i].height };
-            SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); // Red
-            SDL_RenderFillRect(renderer, &rect);
-        }
+// Show min/avg/p99 frame time per phase over the last few seconds
+void drawProfilerOverlay(GlyphAtlas *atlas, SDL_Color color) {
+    char line[100];
+    int y = 440;
+    displayText(atlas, "phase        min    avg    p99 ms", color, 20, y);
+    for (int p = 0; p < NUM_PHASES; ++p) {
+        PhaseStats stats = profilePhaseStats((ProfilePhase)p);
+        y += 30;
+        sprintf(line, "%-10s %6.2f %6.2f %6.2f", profilePhaseName((ProfilePhase)p), stats.min, stats.avg, stats.p99);
+        displayText(atlas, line, color, 20, y);
     }
 }
 
-// Function to check collision between ball and brick
-bool checkCollision(Ball ball, Brick brick) {
-    if (ball.x + ball.size > brick.x &&
-        ball.x < brick.x + brick.width &&
-        ball.y + ball.size > brick.y &&
-        ball.y < brick.y + brick.height) {
-        return true;
+int main(int argc, char* argv[])
+{
+    // Physics rate, e.g. --hz 240 on high-refresh displays
+    int physicsHz = PHYSICS_HZ;
+    bool multiball = false;  // Bricks may release extra balls
+    const char *recordPath = NULL;  // Save each game's inputs for replay
+    float rewindSeconds = 10.f;     // History kept for rewinding
+    const char *tracePath = NULL;   // Chrome trace of the session
+    PacingMode pacingMode = PACING_VSYNC;  // F4 switches while running
+    int fps = 0;                           // Frame rate to pace to; 0 = the display's
+    const char *levelPath = NULL;          // Binary level file, see tools/makelevel.c
+    int debrisPerBrick = DEBRIS_PER_BRICK;  // Particles per destroyed brick; 0 = none
+    const char *playerName = getenv("USER");  // Name on the leaderboard
+    if (!playerName) {
+        playerName = getenv("USERNAME");
     }
-    return false;
-}
-
-bool areAllBricksDestroyed(Brick bricks[]) {
-    for (int i = 0; i < NUM_BRICKS; ++i) {
-        if (bricks[i].active) {
-            return false; // If any brick is still active, return false
-        }
+    if (!playerName || !*playerName) {
+        playerName = "player";
     }
-    return true; // All bricks are destroyed
-}
-
-// Function to handle ball-brick collisions
-void handleBallBrickCollisions(Ball *ball, Brick bricks[]) {
-    for (int i = 0; i < NUM_BRICKS; ++i) {
-        if (bricks[i].active && checkCollision(*ball, bricks[i])) {
-            bricks[i].active = false;  // Deactivate the brick
-            ball->dy = -ball->dy;      // Change the ball's direction
-            score++;                   // Increase score
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--hz") == 0 && i + 1 < argc) {
+            physicsHz = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--multiball") == 0) {
+            multiball = true;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--rewind") == 0 && i + 1 < argc) {
+            rewindSeconds = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--player") == 0 && i + 1 < argc) {
+            playerName = argv[++i];
+        } else if (strcmp(argv[i], "--pacing") == 0 && i + 1 < argc) {
+            if (!parsePacingMode(argv[++i], &pacingMode)) {
+                printf("Unknown pacing mode %s, expected vsync, sleep or uncapped\n", argv[i]);
+            }
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            fps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+            levelPath = argv[++i];
+        } else if (strcmp(argv[i], "--debris") == 0 && i + 1 < argc) {
+            debrisPerBrick = atoi(argv[++i]);
         }
     }
-}
-
-// Function to display text
-void displayText(SDL_Renderer *renderer, TTF_Font *font, const char *text, SDL_Color color, int x, int y) {
-    SDL_Surface *textSurface = TTF_RenderText_Solid(font, text, color);
-    SDL_Texture *textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
-    SDL_Rect textRect = { x, y, textSurface->w, textSurface->h };
-    SDL_RenderCopy(renderer, textTexture, NULL, &textRect);
-    SDL_FreeSurface(textSurface);
-    SDL_DestroyTexture(textTexture);
-}
+    if (physicsHz < 30) {
+        physicsHz = 30;
+    }
 
-int main(int argc, char* argv[])
-{
     // Initialize SDL
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER) < 0) {
         printf("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
         return 1;
     }
@@ -177,7 +120,7 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    // Create renderer for window
+    // Create renderer for window; the brick layer checks for render targets itself
     SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
     if (renderer == NULL) {
         printf("Renderer could not be created! SDL_Error: %s\n", SDL_GetError());
@@ -196,139 +139,228 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    int bestScore = getBestScore();
-    bool playerWon = false;
+    // Rasterize the font once; all HUD text is drawn from this atlas
+    static GlyphAtlas atlas;
+    if (!createGlyphAtlas(&atlas, renderer, font)) {
+        TTF_CloseFont(font);
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
+
     // Set text color as white
     SDL_Color textColor = {255, 255, 255, 255};
 
-    // Game elements
-    Paddle paddle;
-    Ball ball;
-    Brick bricks[NUM_BRICKS];
+    // Shapes are queued here each frame and drawn with one call
+    RectBatch shapes;
+    BrickLayer brickLayer;
+    ParticlePool particles = { 0 };
+    if (!initRectBatch(&shapes, NUM_BRICKS + 16) ||
+        !createBrickLayer(&brickLayer, renderer, SCREEN_WIDTH, SCREEN_HEIGHT, RED) ||
+        !initParticlePool(&particles, MAX_PARTICLES)) {
+        freeParticlePool(&particles);
+        freeRectBatch(&shapes);
+        destroyGlyphAtlas(&atlas);
+        TTF_CloseFont(font);
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
+    // Every finished game goes on the leaderboard. Opening it only maps
+    // the file, and the writes happen on a background thread so the
+    // game-over frame never waits on the disk.
+    Leaderboard *leaderboard = openLeaderboard("scores.dat");
+    if (leaderboard) {
+        importLegacyScores(leaderboard, "scores.txt", playerName);
+    }
+
+    // F3 toggles the phase timing overlay; --trace keeps timing on throughout
+    bool showProfiler = false;
+    if (tracePath) {
+        startProfileTrace();
+        atomic_store(&profilerEnabled, true);
+    }
+
+    // The level file is mapped, not read; pages load as the game touches them
+    Level *level = levelPath ? openLevel(levelPath) : NULL;
+
+    // Each level has its own records; a level file without an id has none
+    int bestScore = 0;
+    if (level && levelId(level) == 0) {
+        printf("%s has no leaderboard id, so its scores are not kept\n", levelPath);
+    } else if (leaderboard) {
+        bestScore = leaderboardBest(leaderboard, level ? levelId(level) : 0);
+    }
+    ScoreWriter *scoreWriter = leaderboard ? startScoreWriter(leaderboard) : NULL;
+
+    // The game runs on its own thread; this one draws its snapshots
+    SimulationSettings settings = {
+        physicsHz, multiball, recordPath, rewindSeconds, scoreWriter, playerName, bestScore, level
+    };
+    Simulation *sim = levelPath && !level ? NULL : startSimulation(&settings);
+    if (!sim) {
+        closeLevel(level);
+        stopScoreWriter(scoreWriter);
+        closeLeaderboard(leaderboard);
+        destroyBrickLayer(&brickLayer);
+        freeParticlePool(&particles);
+        freeRectBatch(&shapes);
+        destroyGlyphAtlas(&atlas);
+        TTF_CloseFont(font);
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
 
-    // Initialize game elements
-    initPaddle(&paddle);
-    initBall(&ball);
-    initBricks(bricks);
+    FramePacer pacer;
+    initFramePacer(&pacer, renderer, window, pacingMode, fps);
 
     // Main game loop
     bool quit = false;
-    bool gameRunning = true;  // Initialize the game as running
     SDL_Event e;
+    const float dt = 1.f / physicsHz;
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+    double lastParticleTime = (double)SDL_GetPerformanceCounter() / frequency;
+
     while (!quit) {
         // Handle events on queue
+        PROFILE_BEGIN(PHASE_EVENTS);
         while (SDL_PollEvent(&e) != 0) {
             if (e.type == SDL_QUIT) {
                 quit = true;
             }
-            switch (e.key.keysym.sym) {
-                case SDLK_LEFT:
-                    paddle.x -= PADDLE_SPEED;
-                    if (paddle.x < 0) {
-                        paddle.x = 0;
-                    }
-                    break;
-                case SDLK_RIGHT:
-                    paddle.x += PADDLE_SPEED;
-                    if (paddle.x > SCREEN_WIDTH - PADDLE_WIDTH) {
-                        paddle.x = SCREEN_WIDTH - PADDLE_WIDTH;
-                    }
-                    break;
-                    // ... other key handling ...
+            if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET) {
+                invalidateBrickLayer(&brickLayer); // Texture contents were lost
             }
-
-            if (e.type == SDL_KEYDOWN) {
-                if (e.key.keysym.sym == SDLK_r && !gameRunning) {
-                    // Reset the game when 'R' is pressed after Game Over
-                    gameRunning = true;
-                    gameOver = false;
-                    playerWon = false;
-                    score = 0;
-                    initPaddle(&paddle);
-                    initBall(&ball);
-                    initBricks(bricks);
-                }
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3) {
+                showProfiler = !showProfiler;
+                atomic_store(&profilerEnabled, showProfiler || tracePath);
+            }
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F4 && !e.key.repeat) {
+                setPacingMode(&pacer, (PacingMode)((pacer.mode + 1) % NUM_PACING_MODES));
+                printf("Frame pacing: %s\n", pacingModeName(pacer.mode));
             }
+            simulationEvent(sim, &e);
+        }
+        // Sample the devices as late as possible before the next steps
+        pollSimulationInput(sim);
+        PROFILE_END(PHASE_EVENTS);
+
+        // Draw the newest state; its brick events are only new once
+        bool isNew;
+        const GameSnapshot *snapshot = latestGameSnapshot(sim, &isNew);
+        bool gameRunning = !snapshot->gameOver;
+        double now = (double)SDL_GetPerformanceCounter() / frequency;
+
+        // Debris from the bricks this snapshot destroyed, moved by real time
+        // so it flows the same at any physics rate. The game-over snapshot
+        // carries the final step's bricks too, so this comes first.
+        PROFILE_BEGIN(PHASE_PARTICLES);
+        if (isNew && debrisPerBrick > 0) {
+            spawnBrickDebris(&particles, &snapshot->bricks, &snapshot->brickEvents, debrisPerBrick, 0xFF0000FF);
+        }
+        float elapsed = (float)(now - lastParticleTime);
+        updateParticles(&particles, elapsed < 0.1f ? elapsed : 0.1f);
+        lastParticleTime = now;
+        PROFILE_END(PHASE_PARTICLES);
+
+        PROFILE_BEGIN(PHASE_DRAW);
+        if (isNew) {
+            updateBrickLayer(&brickLayer, &shapes, &snapshot->bricks, &snapshot->brickEvents);
         }
-
         if (gameRunning) {
-            // Your existing game logic for handling ball, collisions, and drawing goes here.
-
-            // Update ball position
-            ball.x += ball.dx;
-            ball.y += ball.dy;
+            // Blend between the last two steps by how far time has moved on
+            float alpha = (float)((now - snapshot->time) / dt);
+            alpha = alpha < 0.f ? 0.f : alpha > 1.f ? 1.f : alpha;
+            Paddle drawnPaddle = interpolatePaddle(&snapshot->paddle, alpha);
 
-            // Collision with walls
-            if (ball.x <= 0 || ball.x >= SCREEN_WIDTH - BALL_SIZE) {
-                ball.dx = -ball.dx;
-            }
-            if (ball.y <= 0) {
-                ball.dy = -ball.dy;
-            }
-            if (ball.y >= SCREEN_HEIGHT - BALL_SIZE) {
-                gameOver = true;
-            }
-
-            // Collision with paddle
-            if (ball.y + BALL_SIZE >= paddle.y &&
-                ball.x + BALL_SIZE > paddle.x &&
-                ball.x < paddle.x + PADDLE_WIDTH) {
-                ball.dy = -ball.dy;
-            }
-
-            // Handle ball-brick collisions
-            handleBallBrickCollisions(&ball, bricks);
-            if (areAllBricksDestroyed(bricks)) {
-                playerWon = true;
-                gameOver = true;
-                gameRunning = false;
-            }
             // Clear screen
             SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black
             SDL_RenderClear(renderer);
 
-            // Draw game elements
-            drawPaddle(renderer, &paddle);
-            drawBall(renderer, &ball);
-            drawBricks(renderer, bricks);
+            // Draw game elements; the bricks come from the cached layer
+            drawBrickLayer(&brickLayer, &shapes, &snapshot->bricks);
+            drawParticles(&shapes, &particles);
+            drawPaddle(&shapes, &drawnPaddle, WHITE);
+            for (int b = 0; b < snapshot->numBalls; ++b) {
+                Ball drawnBall = interpolateBall(&snapshot->balls[b], alpha);
+                drawBall(&shapes, &drawnBall, WHITE);
+            }
+            flushRects(&shapes, renderer);
+        }
+        PROFILE_END(PHASE_DRAW);
 
+        PROFILE_BEGIN(PHASE_TEXT);
+        if (gameRunning) {
             // Display score
             char scoreText[100];
-            sprintf(scoreText, "Score: %d", score);
-            displayText(renderer, font, scoreText, textColor, 20, 700);
-
-            // Check for game over
-            if (gameOver) {
-                if (score > bestScore) {
-                    bestScore = score;
-                    updateBestScore(score); // Update best score in the file
-                }
-                gameRunning = false;
+            sprintf(scoreText, "Score: %d", snapshot->score);
+            displayText(&atlas, scoreText, textColor, 20, 700);
+            if (snapshot->rewinding) {
+                displayText(&atlas, "<< Rewind", textColor, 20, 740);
             }
         }
 
         // Check for game over
         if (!gameRunning) {
-            if (playerWon) {
-                displayText(renderer, font, "You Win! Press R to Restart", textColor, SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2 - 40);
+            if (snapshot->playerWon) {
+                displayText(&atlas, "You Win! Press R to Restart", textColor, SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2 - 40);
             } else {
-                displayText(renderer, font, "Game Over! Press R to Restart", textColor, SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2 - 40);
+                displayText(&atlas, "Game Over! Press R to Restart", textColor, SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2 - 40);
             }
-            //displayText(renderer, font, "Best Score: %d", textColor, SCREEN_WIDTH - 220, 760);
+            //displayText(&atlas, "Best Score: %d", textColor, SCREEN_WIDTH - 220, 760);
         }
         // Display best score
         char bestScoreText[100];
-        sprintf(bestScoreText, "Best Score: %d", bestScore);
-        displayText(renderer, font, bestScoreText, textColor, SCREEN_WIDTH - 220, 700);
+        sprintf(bestScoreText, "Best Score: %d", snapshot->bestScore);
+        displayText(&atlas, bestScoreText, textColor, SCREEN_WIDTH - 220, 700);
+
+        if (showProfiler) {
+            drawProfilerOverlay(&atlas, textColor);
+            char pacingText[100];
+            sprintf(pacingText, "pacing: %s  particles: %d / %d", pacingModeName(pacer.mode),
+                    particles.count, particles.limit);
+            displayText(&atlas, pacingText, textColor, 20, 410);
+        }
+
+        // Draw all queued text in one batch
+        flushText(&atlas);
+        PROFILE_END(PHASE_TEXT);
 
         // Update the screen
+        PROFILE_BEGIN(PHASE_PRESENT);
         SDL_RenderPresent(renderer);
+        simulationPresented(sim);
+        PROFILE_END(PHASE_PRESENT);
+        if (atomic_load_explicit(&profilerEnabled, memory_order_relaxed)) {
+            profileEndFrame();
+        }
 
-        // Cap the frame rate
-        SDL_Delay(16); // Approximately 60 frames per second
+        // Wait for the next frame as the pacing mode says; the frame rate
+        // does not set the game speed
+        paceFrame(&pacer);
+
+        // Carry fewer particles while frames run over budget
+        adaptParticleLimit(&particles, pacer.frameTime, pacer.period);
     }
 
     // Cleanup
+    stopSimulation(sim);
+    closeLevel(level);  // Snapshots no longer point into it
+    printPacingStats(&pacer);
+    if (tracePath) {
+        writeProfileTrace(tracePath);
+        stopProfileTrace();
+    }
+    stopScoreWriter(scoreWriter);  // Finishes any pending write
+    closeLeaderboard(leaderboard);
+    destroyBrickLayer(&brickLayer);
+    freeParticlePool(&particles);
+    freeRectBatch(&shapes);
+    destroyGlyphAtlas(&atlas);
     TTF_CloseFont(font);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
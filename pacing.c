@@ -0,0 +1,143 @@
+#include "pacing.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const char *MODE_NAMES[NUM_PACING_MODES] = { "vsync", "sleep", "uncapped" };
+
+// Width of a histogram bucket, in seconds
+static const double BUCKET_SECONDS = 0.0001;
+
+// Stop sleeping this long before the deadline on top of the expected
+// oversleep, and spin the rest
+static const double SPIN_MARGIN = 0.0002;
+
+void initFramePacer(FramePacer *pacer, SDL_Renderer *renderer, SDL_Window *window, PacingMode mode, int fps) {
+    memset(pacer, 0, sizeof(*pacer));
+    pacer->renderer = renderer;
+    pacer->frequency = (double)SDL_GetPerformanceFrequency();
+    if (fps <= 0) {
+        SDL_DisplayMode display;
+        int index = SDL_GetWindowDisplayIndex(window);
+        bool known = index >= 0 && SDL_GetCurrentDisplayMode(index, &display) == 0 && display.refresh_rate > 0;
+        fps = known ? display.refresh_rate : 60;
+    }
+    pacer->period = 1.0 / fps;
+    pacer->sleepOvershoot = 0.001;
+    for (int m = 0; m < NUM_PACING_MODES; ++m) {
+        pacer->stats[m].min = 1e9;
+    }
+    setPacingMode(pacer, mode);
+}
+
+void setPacingMode(FramePacer *pacer, PacingMode mode) {
+    if (mode == PACING_VSYNC && SDL_RenderSetVSync(pacer->renderer, 1) != 0) {
+        printf("VSync is not available, sleeping between frames instead. SDL_Error: %s\n", SDL_GetError());
+        mode = PACING_SLEEP;
+    }
+    if (mode != PACING_VSYNC) {
+        SDL_RenderSetVSync(pacer->renderer, 0);
+    }
+    // Frames from here on count towards the new mode's statistics
+    pacer->mode = mode;
+    pacer->lastPresent = SDL_GetPerformanceCounter();
+    pacer->deadline = pacer->lastPresent;
+}
+
+static void recordFrame(PacingStats *stats, double seconds, double target) {
+    stats->frames++;
+    stats->total += seconds;
+    if (seconds < stats->min) {
+        stats->min = seconds;
+    }
+    if (seconds > stats->max) {
+        stats->max = seconds;
+    }
+    if (target > 0 && seconds > target * 1.5) {
+        stats->missed++;
+    }
+    int bucket = (int)(seconds / BUCKET_SECONDS);
+    stats->histogram[bucket < PACING_BUCKETS ? bucket : PACING_BUCKETS - 1]++;
+}
+
+// Wait for the deadline: sleep in 1 ms steps while that cannot overshoot
+// it, then spin
+static void waitUntil(FramePacer *pacer, Uint64 deadline) {
+    for (;;) {
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (now >= deadline) {
+            return;
+        }
+        double remaining = (double)(deadline - now) / pacer->frequency;
+        if (remaining > 0.001 + pacer->sleepOvershoot + SPIN_MARGIN) {
+            SDL_Delay(1);
+            // Follow how much longer than asked the OS really sleeps
+            double slept = (double)(SDL_GetPerformanceCounter() - now) / pacer->frequency;
+            double overshoot = slept > 0.001 ? slept - 0.001 : 0.0;
+            pacer->sleepOvershoot += (overshoot - pacer->sleepOvershoot) * 0.1;
+        }
+    }
+}
+
+void paceFrame(FramePacer *pacer) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    double frameTime = (double)(now - pacer->lastPresent) / pacer->frequency;
+    recordFrame(&pacer->stats[pacer->mode], frameTime, pacer->mode == PACING_UNCAPPED ? 0.0 : pacer->period);
+    pacer->frameTime = frameTime;
+
+    if (pacer->mode == PACING_SLEEP) {
+        // Deadlines follow a fixed grid; after a long frame start again
+        // from now rather than rushing frames out to catch up
+        pacer->deadline += (Uint64)(pacer->period * pacer->frequency);
+        if (pacer->deadline < now) {
+            pacer->deadline = now;
+        }
+        waitUntil(pacer, pacer->deadline);
+    }
+    pacer->lastPresent = now;
+}
+
+const char *pacingModeName(PacingMode mode) {
+    return MODE_NAMES[mode];
+}
+
+bool parsePacingMode(const char *name, PacingMode *mode) {
+    for (int m = 0; m < NUM_PACING_MODES; ++m) {
+        if (strcmp(name, MODE_NAMES[m]) == 0) {
+            *mode = (PacingMode)m;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Frame time below which a fraction p of the frames fall, in seconds
+static double percentile(const PacingStats *stats, double p) {
+    long target = (long)(p * stats->frames);
+    long seen = 0;
+    for (int b = 0; b < PACING_BUCKETS; ++b) {
+        seen += stats->histogram[b];
+        if (seen > target) {
+            double upper = (b + 1) * BUCKET_SECONDS;
+            return upper < stats->max ? upper : stats->max;
+        }
+    }
+    return stats->max;
+}
+
+void printPacingStats(const FramePacer *pacer) {
+    printf("Frame times (target %.2f ms):\n", pacer->period * 1e3);
+    for (int m = 0; m < NUM_PACING_MODES; ++m) {
+        const PacingStats *stats = &pacer->stats[m];
+        if (stats->frames == 0) {
+            continue;
+        }
+        printf("  %-9s %7ld frames  avg %6.2f  min %6.2f  p50 %6.2f  p99 %6.2f  max %6.2f ms",
+               MODE_NAMES[m], stats->frames, stats->total / stats->frames * 1e3, stats->min * 1e3,
+               percentile(stats, 0.50) * 1e3, percentile(stats, 0.99) * 1e3, stats->max * 1e3);
+        if (m != PACING_UNCAPPED) {
+            printf("  missed %ld", stats->missed);
+        }
+        printf("\n");
+    }
+}
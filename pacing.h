@@ -0,0 +1,55 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+// How the render loop waits between frames
+typedef enum {
+    PACING_VSYNC,     // Present waits for the display
+    PACING_SLEEP,     // Sleep until the frame deadline, spinning the last bit
+    PACING_UNCAPPED,  // Render as fast as possible
+    NUM_PACING_MODES
+} PacingMode;
+
+// Frame times kept per mode in 0.1 ms buckets, for the report on exit
+#define PACING_BUCKETS 2500
+
+typedef struct {
+    long frames;
+    long missed;           // Frames over 1.5 times the target period
+    double total, min, max;  // Seconds
+    int histogram[PACING_BUCKETS];
+} PacingStats;
+
+typedef struct {
+    SDL_Renderer *renderer;
+    PacingMode mode;
+    double period;        // Target frame time for vsync and sleep, in seconds
+    double frequency;     // Performance counter ticks per second
+    Uint64 lastPresent;
+    double frameTime;     // Last frame, present to present, in seconds
+    Uint64 deadline;      // Next frame start in PACING_SLEEP
+    double sleepOvershoot;  // How late SDL_Delay(1) tends to wake, in seconds
+    PacingStats stats[NUM_PACING_MODES];
+} FramePacer;
+
+// fps <= 0 uses the refresh rate of the window's display
+void initFramePacer(FramePacer *pacer, SDL_Renderer *renderer, SDL_Window *window, PacingMode mode, int fps);
+
+// Switch modes at runtime; vsync falls back to sleeping if unsupported
+void setPacingMode(FramePacer *pacer, PacingMode mode);
+
+// Call right after presenting: records the frame time and waits until the
+// next frame should start
+void paceFrame(FramePacer *pacer);
+
+const char *pacingModeName(PacingMode mode);
+
+// Parse "vsync", "sleep" or "uncapped"; false if unknown
+bool parsePacingMode(const char *name, PacingMode *mode);
+
+// Frame time statistics of every mode that was used
+void printPacingStats(const FramePacer *pacer);
+
+#endif
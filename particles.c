@@ -0,0 +1,225 @@
+#include "particles.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PARTICLES_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+// Downward acceleration, pixels per second squared
+static const float GRAVITY = 900.f;
+
+// The limit never drops below this, so a slow machine still shows debris
+static const int MIN_PARTICLE_LIMIT = 1024;
+
+// Frames within budget before the limit is raised again, and by how much
+static const int CALM_FRAMES = 30;
+static const int LIMIT_STEPS = 32;  // Raise by capacity / LIMIT_STEPS
+
+// Move particles [0, count) by dt; returns true if any of them died
+typedef bool (*ParticleKernel)(ParticlePool *pool, int count, float dt);
+
+static ParticleKernel updateKernel = NULL;
+static const char *updateKernelName = "none";
+
+// Reference kernel, also used for the tail the vector kernels leave
+static bool updateScalar(ParticlePool *pool, int begin, int count, float dt) {
+    bool anyDead = false;
+    for (int i = begin; i < count; ++i) {
+        pool->x[i] += pool->dx[i] * dt;
+        pool->y[i] += pool->dy[i] * dt;
+        pool->dy[i] += GRAVITY * dt;
+        pool->life[i] -= dt;
+        anyDead |= pool->life[i] <= 0.f;
+    }
+    return anyDead;
+}
+
+static bool updateReference(ParticlePool *pool, int count, float dt) {
+    return updateScalar(pool, 0, count, dt);
+}
+
+#ifdef PARTICLES_X86_KERNELS
+
+// Four particles per instruction
+__attribute__((target("sse2")))
+static bool updateSse2(ParticlePool *pool, int count, float dt) {
+    const __m128 step = _mm_set1_ps(dt), fall = _mm_set1_ps(GRAVITY * dt), zero = _mm_setzero_ps();
+    __m128 dead = zero;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 dy = _mm_loadu_ps(&pool->dy[i]);
+        _mm_storeu_ps(&pool->x[i], _mm_add_ps(_mm_loadu_ps(&pool->x[i]), _mm_mul_ps(_mm_loadu_ps(&pool->dx[i]), step)));
+        _mm_storeu_ps(&pool->y[i], _mm_add_ps(_mm_loadu_ps(&pool->y[i]), _mm_mul_ps(dy, step)));
+        _mm_storeu_ps(&pool->dy[i], _mm_add_ps(dy, fall));
+        __m128 life = _mm_sub_ps(_mm_loadu_ps(&pool->life[i]), step);
+        _mm_storeu_ps(&pool->life[i], life);
+        dead = _mm_or_ps(dead, _mm_cmple_ps(life, zero));
+    }
+    return updateScalar(pool, i, count, dt) | (_mm_movemask_ps(dead) != 0);
+}
+
+// Eight particles per instruction
+__attribute__((target("avx2")))
+static bool updateAvx2(ParticlePool *pool, int count, float dt) {
+    const __m256 step = _mm256_set1_ps(dt), fall = _mm256_set1_ps(GRAVITY * dt), zero = _mm256_setzero_ps();
+    __m256 dead = zero;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 dy = _mm256_loadu_ps(&pool->dy[i]);
+        _mm256_storeu_ps(&pool->x[i], _mm256_add_ps(_mm256_loadu_ps(&pool->x[i]), _mm256_mul_ps(_mm256_loadu_ps(&pool->dx[i]), step)));
+        _mm256_storeu_ps(&pool->y[i], _mm256_add_ps(_mm256_loadu_ps(&pool->y[i]), _mm256_mul_ps(dy, step)));
+        _mm256_storeu_ps(&pool->dy[i], _mm256_add_ps(dy, fall));
+        __m256 life = _mm256_sub_ps(_mm256_loadu_ps(&pool->life[i]), step);
+        _mm256_storeu_ps(&pool->life[i], life);
+        dead = _mm256_or_ps(dead, _mm256_cmp_ps(life, zero, _CMP_LE_OQ));
+    }
+    return updateScalar(pool, i, count, dt) | (_mm256_movemask_ps(dead) != 0);
+}
+
+#endif
+
+static void selectParticleKernel(void) {
+#ifdef PARTICLES_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        updateKernel = updateAvx2;
+        updateKernelName = "avx2";
+        return;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        updateKernel = updateSse2;
+        updateKernelName = "sse2";
+        return;
+    }
+#endif
+    updateKernel = updateReference;
+    updateKernelName = "scalar";
+}
+
+const char *particleKernelName(void) {
+    return updateKernelName;
+}
+
+bool initParticlePool(ParticlePool *pool, int capacity) {
+    memset(pool, 0, sizeof(*pool));
+    pool->x = malloc(sizeof(float) * capacity);
+    pool->y = malloc(sizeof(float) * capacity);
+    pool->dx = malloc(sizeof(float) * capacity);
+    pool->dy = malloc(sizeof(float) * capacity);
+    pool->life = malloc(sizeof(float) * capacity);
+    pool->color = malloc(sizeof(uint32_t) * capacity);
+    if (!pool->x || !pool->y || !pool->dx || !pool->dy || !pool->life || !pool->color) {
+        printf("Failed to allocate particles!\n");
+        freeParticlePool(pool);
+        return false;
+    }
+    pool->capacity = capacity;
+    pool->limit = capacity;
+    pool->rng = 0x9E3779B9u;
+
+    // Pick the update kernel while still single threaded
+    if (!updateKernel) {
+        selectParticleKernel();
+    }
+    return true;
+}
+
+void freeParticlePool(ParticlePool *pool) {
+    free(pool->x);
+    free(pool->y);
+    free(pool->dx);
+    free(pool->dy);
+    free(pool->life);
+    free(pool->color);
+    memset(pool, 0, sizeof(*pool));
+}
+
+// Uniform in [0, 1) (xorshift32)
+static float particleRandom(ParticlePool *pool) {
+    uint32_t r = pool->rng;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    pool->rng = r;
+    return (r >> 8) * (1.f / 16777216.f);
+}
+
+void spawnDebris(ParticlePool *pool, float x, float y, float width, float height, uint32_t color, int n) {
+    const float twoPi = 6.2831853f;
+    int room = pool->limit - pool->count;
+    if (n > room) {
+        n = room;
+    }
+    for (int k = 0; k < n; ++k) {
+        int i = pool->count++;
+        float angle = particleRandom(pool) * twoPi;
+        float speed = 60.f + particleRandom(pool) * 180.f;
+        pool->x[i] = x + particleRandom(pool) * width;
+        pool->y[i] = y + particleRandom(pool) * height;
+        pool->dx[i] = cosf(angle) * speed;
+        pool->dy[i] = sinf(angle) * speed - 150.f;  // Kicked upwards first
+        pool->life[i] = PARTICLE_LIFETIME * (0.5f + 0.5f * particleRandom(pool));
+        pool->color[i] = color;
+    }
+}
+
+void spawnBrickDebris(ParticlePool *pool, const BrickStore *bricks, const BrickEvents *events,
+                      int perBrick, uint32_t defaultColor) {
+    for (int e = 0; e < events->count; ++e) {
+        int i = events->destroyed[e];
+        uint32_t color = bricks->colors ? bricks->colors[i] : defaultColor;
+        spawnDebris(pool, brickX(bricks, i), brickY(bricks, i), brickWidth(bricks, i), brickHeight(bricks, i),
+                    color, perBrick);
+    }
+}
+
+// Fill each dead particle's slot with the last live one
+static void removeDeadParticles(ParticlePool *pool) {
+    int i = 0;
+    while (i < pool->count) {
+        if (pool->life[i] > 0.f) {
+            ++i;
+            continue;
+        }
+        int last = --pool->count;
+        pool->x[i] = pool->x[last];
+        pool->y[i] = pool->y[last];
+        pool->dx[i] = pool->dx[last];
+        pool->dy[i] = pool->dy[last];
+        pool->life[i] = pool->life[last];
+        pool->color[i] = pool->color[last];
+    }
+}
+
+void updateParticles(ParticlePool *pool, float dt) {
+    if (pool->count > 0 && updateKernel(pool, pool->count, dt)) {
+        removeDeadParticles(pool);
+    }
+}
+
+void adaptParticleLimit(ParticlePool *pool, double frameTime, double budget) {
+    if (budget <= 0) {
+        return;
+    }
+    if (frameTime > budget * 1.25) {
+        // A missed frame: shed a quarter of the particles straight away
+        int limit = pool->limit - pool->limit / 4;
+        pool->limit = limit > MIN_PARTICLE_LIMIT ? limit : MIN_PARTICLE_LIMIT;
+        if (pool->limit > pool->capacity) {
+            pool->limit = pool->capacity;
+        }
+        if (pool->count > pool->limit) {
+            pool->count = pool->limit;
+        }
+        pool->calmFrames = 0;
+    } else if (pool->limit < pool->capacity && ++pool->calmFrames >= CALM_FRAMES) {
+        int limit = pool->limit + pool->capacity / LIMIT_STEPS;
+        pool->limit = limit < pool->capacity ? limit : pool->capacity;
+        pool->calmFrames = 0;
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+// Debris thrown off destroyed bricks; purely visual, the game never sees
+// it. Particles live in a pool of parallel arrays allocated once at a
+// fixed capacity. Live particles are packed at the front, so an update is
+// one SIMD pass over contiguous floats and nothing is allocated per frame.
+typedef struct {
+    float *x, *y;
+    float *dx, *dy;     // Pixels per second
+    float *life;        // Seconds left
+    uint32_t *color;    // 0xRRGGBBAA at full brightness
+    int count;          // Live particles, at [0, count)
+    int capacity;       // Fixed at creation
+    int limit;          // Adaptive cap on count, at most capacity
+    int calmFrames;     // Frames within budget since the limit last moved
+    uint32_t rng;
+} ParticlePool;
+
+// Side of a particle's square, in pixels
+static const float PARTICLE_SIZE = 3.f;
+
+// Longest a particle lives; it fades out over its life
+static const float PARTICLE_LIFETIME = 1.2f;
+
+// Particles per destroyed brick unless set otherwise
+static const int DEBRIS_PER_BRICK = 24;
+
+bool initParticlePool(ParticlePool *pool, int capacity);
+void freeParticlePool(ParticlePool *pool);
+
+// Burst n particles out of a rectangle; particles over the limit are not
+// spawned
+void spawnDebris(ParticlePool *pool, float x, float y, float width, float height, uint32_t color, int n);
+
+// Debris for every brick in events, in the brick's colour or defaultColor
+void spawnBrickDebris(ParticlePool *pool, const BrickStore *bricks, const BrickEvents *events,
+                      int perBrick, uint32_t defaultColor);
+
+// Move every particle by dt seconds under gravity and drop the dead ones.
+// Uses the widest kernel the CPU supports (AVX2, SSE2 or scalar).
+void updateParticles(ParticlePool *pool, float dt);
+const char *particleKernelName(void);
+
+// Adjust the limit to the frame time: cut it (and the live particles) at
+// once when a frame runs over budget, and raise it slowly after a run of
+// frames within budget
+void adaptParticleLimit(ParticlePool *pool, double frameTime, double budget);
+
+#endif
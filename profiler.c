@@ -0,0 +1,174 @@
+#include "profiler.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+atomic_bool profilerEnabled = false;
+
+static const char *PHASE_NAMES[NUM_PHASES] = {
+    "events", "physics", "collisions", "particles", "draw", "text", "present"
+};
+
+// Nanoseconds spent in each phase during the current frame; collisions are
+// added from worker threads
+static atomic_uint_fast64_t frameTotals[NUM_PHASES];
+
+// Per-frame totals of the last PROFILE_HISTORY frames
+static uint64_t history[NUM_PHASES][PROFILE_HISTORY];
+static int historyNext = 0;
+static int historyCount = 0;
+
+// Trace events of the session, if tracing
+typedef struct {
+    uint64_t start, duration;  // Nanoseconds
+    int phase;                 // ProfilePhase, or -1 for the collision counter
+    int thread;                // Trace thread id, numbered from 1
+} TraceEvent;
+
+// Stop collecting past this many events (about 24 MB)
+static const int MAX_TRACE_EVENTS = 1 << 20;
+
+static TraceEvent *traceEvents = NULL;
+static int numTraceEvents = 0;
+static int traceCapacity = 0;
+static bool tracing = false;
+static uint64_t traceOrigin = 0;
+
+// Phases are recorded on the render and simulation threads
+static pthread_mutex_t traceMutex = PTHREAD_MUTEX_INITIALIZER;
+static atomic_int numTraceThreads = 0;
+static _Thread_local int traceThread = 0;
+
+uint64_t profileNow(void) {
+    struct timespec ts;
+#ifdef CLOCK_MONOTONIC
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void appendTraceEvent(const TraceEvent *event) {
+    if (numTraceEvents == traceCapacity) {
+        if (traceCapacity == MAX_TRACE_EVENTS) {
+            return;
+        }
+        int capacity = traceCapacity ? traceCapacity * 2 : 4096;
+        TraceEvent *events = realloc(traceEvents, sizeof(TraceEvent) * capacity);
+        if (!events) {
+            return;
+        }
+        traceEvents = events;
+        traceCapacity = capacity;
+    }
+    traceEvents[numTraceEvents++] = *event;
+}
+
+static void addTraceEvent(int phase, uint64_t start, uint64_t duration) {
+    if (!traceThread) {
+        traceThread = atomic_fetch_add(&numTraceThreads, 1) + 1;
+    }
+    TraceEvent event = { start, duration, phase, traceThread };
+    pthread_mutex_lock(&traceMutex);
+    appendTraceEvent(&event);
+    pthread_mutex_unlock(&traceMutex);
+}
+
+void profileRecord(ProfilePhase phase, uint64_t start) {
+    if (start == 0) {
+        return;  // Profiling was switched on inside the phase
+    }
+    uint64_t end = profileNow();
+    atomic_fetch_add_explicit(&frameTotals[phase], end - start, memory_order_relaxed);
+    // Collisions happen thousands of times per frame and on several
+    // threads; they reach the trace as one counter per frame instead
+    if (tracing && phase != PHASE_COLLISIONS) {
+        addTraceEvent(phase, start, end - start);
+    }
+}
+
+void profileEndFrame(void) {
+    for (int p = 0; p < NUM_PHASES; ++p) {
+        history[p][historyNext] = atomic_exchange_explicit(&frameTotals[p], 0, memory_order_relaxed);
+    }
+    if (tracing) {
+        addTraceEvent(-1, profileNow(), history[PHASE_COLLISIONS][historyNext]);
+    }
+    historyNext = (historyNext + 1) % PROFILE_HISTORY;
+    if (historyCount < PROFILE_HISTORY) {
+        historyCount++;
+    }
+}
+
+static int compareU64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+PhaseStats profilePhaseStats(ProfilePhase phase) {
+    PhaseStats stats = { 0, 0, 0 };
+    if (historyCount == 0) {
+        return stats;
+    }
+    uint64_t sorted[PROFILE_HISTORY];
+    memcpy(sorted, history[phase], sizeof(uint64_t) * historyCount);
+    qsort(sorted, historyCount, sizeof(uint64_t), compareU64);
+    uint64_t total = 0;
+    for (int f = 0; f < historyCount; ++f) {
+        total += sorted[f];
+    }
+    stats.min = sorted[0] * 1e-6;
+    stats.avg = (double)total / historyCount * 1e-6;
+    stats.p99 = sorted[(historyCount - 1) * 99 / 100] * 1e-6;
+    return stats;
+}
+
+const char *profilePhaseName(ProfilePhase phase) {
+    return PHASE_NAMES[phase];
+}
+
+void startProfileTrace(void) {
+    tracing = true;
+    traceOrigin = profileNow();
+    numTraceEvents = 0;
+}
+
+bool writeProfileTrace(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        printf("Failed to open trace file %s!\n", path);
+        return false;
+    }
+    // Timestamps and durations are in microseconds
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (int e = 0; e < numTraceEvents; ++e) {
+        const TraceEvent *event = &traceEvents[e];
+        double ts = (event->start >= traceOrigin ? event->start - traceOrigin : 0) * 1e-3;
+        if (event->phase < 0) {
+            fprintf(file, "{\"name\":\"collisions\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,"
+                          "\"args\":{\"us\":%.3f}}", ts, event->thread, event->duration * 1e-3);
+        } else {
+            fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                    PHASE_NAMES[event->phase], ts, event->duration * 1e-3, event->thread);
+        }
+        fprintf(file, e + 1 < numTraceEvents ? ",\n" : "\n");
+    }
+    fprintf(file, "]}\n");
+    bool ok = fclose(file) == 0;
+    if (numTraceEvents == MAX_TRACE_EVENTS) {
+        printf("Trace truncated after %d events\n", MAX_TRACE_EVENTS);
+    }
+    return ok;
+}
+
+void stopProfileTrace(void) {
+    tracing = false;
+    free(traceEvents);
+    traceEvents = NULL;
+    numTraceEvents = traceCapacity = 0;
+}
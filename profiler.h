@@ -0,0 +1,65 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Per-phase frame timers. Wrap a phase in PROFILE_BEGIN/PROFILE_END and
+// call profileEndFrame once per frame; each phase's time per frame is kept
+// for the last PROFILE_HISTORY frames. While profilerEnabled is false the
+// macros cost one predictable branch.
+typedef enum {
+    PHASE_EVENTS,
+    PHASE_PHYSICS,
+    PHASE_COLLISIONS,  // Inside physics; summed over all balls and threads
+    PHASE_PARTICLES,   // Spawning and moving debris
+    PHASE_DRAW,
+    PHASE_TEXT,
+    PHASE_PRESENT,
+    NUM_PHASES
+} ProfilePhase;
+
+#define PROFILE_HISTORY 240
+
+typedef struct {
+    double min, avg, p99;  // Milliseconds per frame
+} PhaseStats;
+
+// Set by the main thread, read by every thread that times a phase. Only
+// the flag itself is shared, so relaxed loads are enough.
+extern atomic_bool profilerEnabled;
+
+// Monotonic time in nanoseconds
+uint64_t profileNow(void);
+
+// Add the time since start to phase. Phases other than PHASE_COLLISIONS
+// also become trace events when tracing.
+void profileRecord(ProfilePhase phase, uint64_t start);
+
+// The flag is read once per phase: a phase that started untimed is not
+// recorded even if timing was switched on meanwhile
+#define PROFILE_BEGIN(phase) \
+    uint64_t profileStart_##phase = \
+        atomic_load_explicit(&profilerEnabled, memory_order_relaxed) ? profileNow() : 0
+#define PROFILE_END(phase) \
+    do { \
+        if (profileStart_##phase != 0) { \
+            profileRecord(phase, profileStart_##phase); \
+        } \
+    } while (0)
+
+// Close the current frame: store each phase's total and start again
+void profileEndFrame(void);
+
+// Rolling statistics over the stored frames
+PhaseStats profilePhaseStats(ProfilePhase phase);
+const char *profilePhaseName(ProfilePhase phase);
+
+// Keep every recorded phase as a Chrome trace_event; written by
+// writeProfileTrace (open it in chrome://tracing or Perfetto)
+void startProfileTrace(void);
+bool writeProfileTrace(const char *path);
+void stopProfileTrace(void);
+
+#endif
@@ -0,0 +1,194 @@
+#include "render.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Resize the buffers to hold capacity rectangles. Indices only depend on
+// the rectangle's slot, so they are written once when the slot is created.
+static bool growRectBatch(RectBatch *batch, int capacity) {
+    SDL_Vertex *vertices = realloc(batch->vertices, sizeof(SDL_Vertex) * 4 * capacity);
+    if (!vertices) {
+        return false;
+    }
+    batch->vertices = vertices;
+    int *indices = realloc(batch->indices, sizeof(int) * 6 * capacity);
+    if (!indices) {
+        return false;
+    }
+    batch->indices = indices;
+
+    for (int r = batch->capacity; r < capacity; ++r) {
+        int *index = &batch->indices[r * 6];
+        int base = r * 4;
+        index[0] = base;
+        index[1] = base + 1;
+        index[2] = base + 2;
+        index[3] = base + 2;
+        index[4] = base + 3;
+        index[5] = base;
+    }
+    batch->capacity = capacity;
+    return true;
+}
+
+bool initRectBatch(RectBatch *batch, int capacity) {
+    batch->vertices = NULL;
+    batch->indices = NULL;
+    batch->numRects = 0;
+    batch->capacity = 0;
+    if (!growRectBatch(batch, capacity > 0 ? capacity : 64)) {
+        printf("Failed to allocate rectangle batch!\n");
+        freeRectBatch(batch);
+        return false;
+    }
+    return true;
+}
+
+void freeRectBatch(RectBatch *batch) {
+    free(batch->vertices);
+    free(batch->indices);
+    batch->vertices = NULL;
+    batch->indices = NULL;
+    batch->numRects = batch->capacity = 0;
+}
+
+bool addRect(RectBatch *batch, float x, float y, float width, float height, SDL_Color color) {
+    if (batch->numRects == batch->capacity && !growRectBatch(batch, batch->capacity * 2)) {
+        return false;
+    }
+    SDL_Vertex *v = &batch->vertices[batch->numRects * 4];
+    v[0] = (SDL_Vertex){ { x, y }, color, { 0.f, 0.f } };
+    v[1] = (SDL_Vertex){ { x + width, y }, color, { 0.f, 0.f } };
+    v[2] = (SDL_Vertex){ { x + width, y + height }, color, { 0.f, 0.f } };
+    v[3] = (SDL_Vertex){ { x, y + height }, color, { 0.f, 0.f } };
+    batch->numRects++;
+    return true;
+}
+
+void flushRects(RectBatch *batch, SDL_Renderer *renderer) {
+    if (batch->numRects > 0) {
+        SDL_RenderGeometry(renderer, NULL, batch->vertices, batch->numRects * 4,
+                           batch->indices, batch->numRects * 6);
+        batch->numRects = 0;
+    }
+}
+
+// Function to draw paddle
+void drawPaddle(RectBatch *batch, const Paddle *paddle, SDL_Color color) {
+    addRect(batch, (int)paddle->x, (int)paddle->y, (int)paddle->width, (int)paddle->height, color);
+}
+
+// Function to draw ball
+void drawBall(RectBatch *batch, const Ball *ball, SDL_Color color) {
+    addRect(batch, (int)(ball->x - ball->size / 2), (int)(ball->y - ball->size / 2), (int)ball->size, (int)ball->size, color);
+}
+
+// Function to draw bricks, visiting only the surviving ones
+void drawBricks(RectBatch *batch, const BrickStore *bricks, SDL_Color color) {
+    for (int i = nextActiveBrick(bricks, 0); i >= 0; i = nextActiveBrick(bricks, i + 1)) {
+        if (bricks->colors) {
+            // Level files give every brick its own colour, as 0xRRGGBBAA
+            uint32_t c = bricks->colors[i];
+            color = (SDL_Color){ c >> 24, (c >> 16) & 0xFF, (c >> 8) & 0xFF, c & 0xFF };
+        }
+        addRect(batch, brickX(bricks, i), brickY(bricks, i), brickWidth(bricks, i), brickHeight(bricks, i), color);
+    }
+}
+
+bool drawParticles(RectBatch *batch, const ParticlePool *particles) {
+    // Grow once for the whole pool, then write the quads straight through
+    int needed = batch->numRects + particles->count;
+    if (needed > batch->capacity) {
+        int capacity = batch->capacity * 2 > needed ? batch->capacity * 2 : needed;
+        if (!growRectBatch(batch, capacity)) {
+            return false;
+        }
+    }
+    SDL_Vertex *v = &batch->vertices[batch->numRects * 4];
+    for (int i = 0; i < particles->count; ++i, v += 4) {
+        // The screen behind is black, so fading to black needs no blending
+        float fade = particles->life[i] * (1.f / PARTICLE_LIFETIME);
+        uint32_t c = particles->color[i];
+        SDL_Color color = { (Uint8)((c >> 24) * fade), (Uint8)(((c >> 16) & 0xFF) * fade),
+                            (Uint8)(((c >> 8) & 0xFF) * fade), 255 };
+        float x = particles->x[i], y = particles->y[i];
+        v[0] = (SDL_Vertex){ { x, y }, color, { 0.f, 0.f } };
+        v[1] = (SDL_Vertex){ { x + PARTICLE_SIZE, y }, color, { 0.f, 0.f } };
+        v[2] = (SDL_Vertex){ { x + PARTICLE_SIZE, y + PARTICLE_SIZE }, color, { 0.f, 0.f } };
+        v[3] = (SDL_Vertex){ { x, y + PARTICLE_SIZE }, color, { 0.f, 0.f } };
+    }
+    batch->numRects = needed;
+    return true;
+}
+
+bool createBrickLayer(BrickLayer *layer, SDL_Renderer *renderer, int width, int height, SDL_Color color) {
+    layer->renderer = renderer;
+    layer->color = color;
+    layer->valid = false;
+    layer->texture = NULL;
+    if (!SDL_RenderTargetSupported(renderer)) {
+        printf("Render targets unsupported, drawing bricks directly.\n");
+        return true;
+    }
+    layer->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    if (!layer->texture) {
+        printf("Brick layer texture unavailable, drawing bricks directly. SDL_Error: %s\n", SDL_GetError());
+        return true;
+    }
+    SDL_SetTextureBlendMode(layer->texture, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+void destroyBrickLayer(BrickLayer *layer) {
+    if (layer->texture) {
+        SDL_DestroyTexture(layer->texture);
+        layer->texture = NULL;
+    }
+}
+
+void invalidateBrickLayer(BrickLayer *layer) {
+    layer->valid = false;
+}
+
+void updateBrickLayer(BrickLayer *layer, RectBatch *batch, const BrickStore *bricks, const BrickEvents *events) {
+    SDL_Renderer *renderer = layer->renderer;
+    if (!layer->texture) {
+        return;
+    }
+
+    if (!layer->valid || events->rebuild) {
+        // Redraw the whole field on a transparent background
+        SDL_SetRenderTarget(renderer, layer->texture);
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        SDL_RenderClear(renderer);
+        drawBricks(batch, bricks, layer->color);
+        flushRects(batch, renderer);
+        SDL_SetRenderTarget(renderer, NULL);
+        layer->valid = true;
+    } else if (events->count > 0) {
+        // Punch the destroyed bricks out; blending off so alpha 0 is written
+        SDL_Color clear = { 0, 0, 0, 0 };
+        SDL_SetRenderTarget(renderer, layer->texture);
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+        for (int e = 0; e < events->count; ++e) {
+            int i = events->destroyed[e];
+            addRect(batch, brickX(bricks, i), brickY(bricks, i), brickWidth(bricks, i), brickHeight(bricks, i), clear);
+        }
+        flushRects(batch, renderer);
+        SDL_SetRenderTarget(renderer, NULL);
+    }
+}
+
+void drawBrickLayer(BrickLayer *layer, RectBatch *batch, const BrickStore *bricks) {
+    if (!layer->texture) {
+        drawBricks(batch, bricks, layer->color);
+        flushRects(batch, layer->renderer);
+        return;
+    }
+    if (!layer->valid) {
+        static const BrickEvents noBrickEvents = { .count = 0 };
+        updateBrickLayer(layer, batch, bricks, &noBrickEvents);
+    }
+    SDL_RenderCopy(layer->renderer, layer->texture, NULL, NULL);
+}
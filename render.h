@@ -0,0 +1,63 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+#include "game.h"
+#include "particles.h"
+
+// Solid rectangles queued for one frame and submitted with a single
+// SDL_RenderGeometry call. Colour is per vertex, so every rectangle can
+// have its own. The buffers grow as needed and are kept between frames.
+typedef struct {
+    SDL_Vertex *vertices;
+    int *indices;
+    int numRects;
+    int capacity;  // Rectangles the buffers can hold
+} RectBatch;
+
+bool initRectBatch(RectBatch *batch, int capacity);
+void freeRectBatch(RectBatch *batch);
+
+// Queue a filled rectangle; false if the buffers could not grow
+bool addRect(RectBatch *batch, float x, float y, float width, float height, SDL_Color color);
+
+// Draw every queued rectangle in one call and empty the batch
+void flushRects(RectBatch *batch, SDL_Renderer *renderer);
+
+// Queue game elements into a batch
+void drawPaddle(RectBatch *batch, const Paddle *paddle, SDL_Color color);
+void drawBall(RectBatch *batch, const Ball *ball, SDL_Color color);
+// color is used for bricks without a colour of their own
+void drawBricks(RectBatch *batch, const BrickStore *bricks, SDL_Color color);
+// Particles dim towards black as they die; false if the batch cannot grow
+bool drawParticles(RectBatch *batch, const ParticlePool *particles);
+
+// The brick field cached in a render-target texture. Bricks only change
+// when one is destroyed, so each frame costs one texture copy and the
+// texture is patched by clearing the destroyed bricks' rectangles.
+typedef struct {
+    SDL_Renderer *renderer;
+    SDL_Texture *texture;  // NULL if render targets are unsupported
+    SDL_Color color;
+    bool valid;            // Texture contents match the bricks
+} BrickLayer;
+
+// Without render-target support the layer falls back to drawing every
+// brick each frame, so this only fails on allocation errors
+bool createBrickLayer(BrickLayer *layer, SDL_Renderer *renderer, int width, int height, SDL_Color color);
+void destroyBrickLayer(BrickLayer *layer);
+
+// Force a full redraw, e.g. after SDL_RENDER_TARGETS_RESET
+void invalidateBrickLayer(BrickLayer *layer);
+
+// Bring the texture up to date with the brick events, once per set of
+// events. batch is used as scratch and must be empty.
+void updateBrickLayer(BrickLayer *layer, RectBatch *batch, const BrickStore *bricks, const BrickEvents *events);
+
+// Draw the bricks as of the last update (all of them if the texture
+// needs a full redraw). batch is used as scratch and must be empty.
+void drawBrickLayer(BrickLayer *layer, RectBatch *batch, const BrickStore *bricks);
+
+#endif
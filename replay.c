@@ -0,0 +1,305 @@
+#include "replay.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "level.h"
+
+// File layout, all little-endian:
+//   "BRKR", version, seed, numBricks, dt (float bits), extraBalls,
+//   powerUpChance (float bits), flags, numSteps (u64), finalHash (u64),
+//   numRuns, then numRuns x { paddleDx (float bits), steps }
+static const char REPLAY_MAGIC[4] = { 'B', 'R', 'K', 'R' };
+static const uint32_t REPLAY_VERSION = 1;
+static const uint32_t FLAG_SOLID_FLOOR = 1;
+static const uint32_t FLAG_RANDOM_LAUNCH = 2;
+
+// Most extra balls a replay may ask for; far more than any game has
+static const uint32_t MAX_REPLAY_BALLS = 1 << 20;
+
+// Size of one input run in the file
+static const uint64_t RUN_BYTES = 8;
+
+bool initReplay(Replay *replay, const GameState *state, float dt, int extraBalls) {
+    memset(replay, 0, sizeof(*replay));
+    replay->seed = state->seed;
+    replay->numBricks = state->bricks.count;
+    replay->dt = dt;
+    replay->extraBalls = extraBalls;
+    replay->powerUpChance = state->powerUpChance;
+    replay->solidFloor = state->solidFloor;
+    replay->randomLaunch = state->randomLaunch;
+    replay->runCapacity = 256;
+    replay->runs = malloc(sizeof(InputRun) * replay->runCapacity);
+    return replay->runs != NULL;
+}
+
+void freeReplay(Replay *replay) {
+    free(replay->runs);
+    replay->runs = NULL;
+    replay->numRuns = replay->runCapacity = 0;
+}
+
+bool recordStep(Replay *replay, const GameInput *input) {
+    InputRun *last = replay->numRuns > 0 ? &replay->runs[replay->numRuns - 1] : NULL;
+    if (last && last->paddleDx == input->paddleDx && last->steps < UINT32_MAX) {
+        last->steps++;
+    } else {
+        if (replay->numRuns == replay->runCapacity) {
+            int capacity = replay->runCapacity * 2;
+            InputRun *runs = realloc(replay->runs, sizeof(InputRun) * capacity);
+            if (!runs) {
+                return false;
+            }
+            replay->runs = runs;
+            replay->runCapacity = capacity;
+        }
+        replay->runs[replay->numRuns++] = (InputRun){ input->paddleDx, 1 };
+    }
+    replay->numSteps++;
+    return true;
+}
+
+void finishReplay(Replay *replay, const GameState *state) {
+    replay->finalHash = hashGameState(state);
+}
+
+static uint32_t floatBits(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+static float bitsToFloat(uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static bool writeU32(FILE *file, uint32_t value) {
+    unsigned char bytes[4];
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+    return fwrite(bytes, 1, 4, file) == 4;
+}
+
+static bool writeU64(FILE *file, uint64_t value) {
+    return writeU32(file, (uint32_t)value) && writeU32(file, (uint32_t)(value >> 32));
+}
+
+static bool readU32(FILE *file, uint32_t *value) {
+    unsigned char bytes[4];
+    if (fread(bytes, 1, 4, file) != 4) {
+        return false;
+    }
+    *value = 0;
+    for (int i = 0; i < 4; ++i) {
+        *value |= (uint32_t)bytes[i] << (8 * i);
+    }
+    return true;
+}
+
+// Bytes between the read position and the end of the file
+static bool bytesLeft(FILE *file, uint64_t *left) {
+    long position = ftell(file);
+    if (position < 0 || fseek(file, 0, SEEK_END) != 0) {
+        return false;
+    }
+    long end = ftell(file);
+    if (end < position || fseek(file, position, SEEK_SET) != 0) {
+        return false;
+    }
+    *left = (uint64_t)(end - position);
+    return true;
+}
+
+static bool readU64(FILE *file, uint64_t *value) {
+    uint32_t low, high;
+    if (!readU32(file, &low) || !readU32(file, &high)) {
+        return false;
+    }
+    *value = (uint64_t)high << 32 | low;
+    return true;
+}
+
+bool saveReplay(const Replay *replay, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        printf("Failed to open replay file %s for writing!\n", path);
+        return false;
+    }
+    bool ok = fwrite(REPLAY_MAGIC, 1, 4, file) == 4 &&
+              writeU32(file, REPLAY_VERSION) &&
+              writeU32(file, replay->seed) &&
+              writeU32(file, (uint32_t)replay->numBricks) &&
+              writeU32(file, floatBits(replay->dt)) &&
+              writeU32(file, (uint32_t)replay->extraBalls) &&
+              writeU32(file, floatBits(replay->powerUpChance)) &&
+              writeU32(file, (replay->solidFloor ? FLAG_SOLID_FLOOR : 0) |
+                             (replay->randomLaunch ? FLAG_RANDOM_LAUNCH : 0)) &&
+              writeU64(file, replay->numSteps) &&
+              writeU64(file, replay->finalHash) &&
+              writeU32(file, (uint32_t)replay->numRuns);
+    for (int r = 0; ok && r < replay->numRuns; ++r) {
+        ok = writeU32(file, floatBits(replay->runs[r].paddleDx)) &&
+             writeU32(file, replay->runs[r].steps);
+    }
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        printf("Failed to write replay file %s!\n", path);
+    }
+    return ok;
+}
+
+bool loadReplay(Replay *replay, const char *path) {
+    memset(replay, 0, sizeof(*replay));
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        printf("Failed to open replay file %s!\n", path);
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version, numBricks, dt, extraBalls, powerUpChance, flags, numRuns;
+    bool ok = fread(magic, 1, 4, file) == 4 && memcmp(magic, REPLAY_MAGIC, 4) == 0 &&
+              readU32(file, &version) && version == REPLAY_VERSION &&
+              readU32(file, &replay->seed) &&
+              readU32(file, &numBricks) &&
+              readU32(file, &dt) &&
+              readU32(file, &extraBalls) &&
+              readU32(file, &powerUpChance) &&
+              readU32(file, &flags) &&
+              readU64(file, &replay->numSteps) &&
+              readU64(file, &replay->finalHash) &&
+              readU32(file, &numRuns);
+    uint64_t left = 0;
+    ok = ok && bytesLeft(file, &left);
+
+    // Every value is checked before it sizes anything. Runs are never
+    // empty, so there cannot be more of them than steps, and each takes
+    // RUN_BYTES of the rest of the file.
+    const char *problem = NULL;
+    if (!ok) {
+        problem = "not a replay of this version";
+    } else if (numBricks < 1 || numBricks > MAX_LEVEL_BRICKS) {
+        problem = "brick count out of range";
+    } else if (extraBalls > MAX_REPLAY_BALLS) {
+        problem = "ball count out of range";
+    } else if (numRuns > replay->numSteps || numRuns > INT32_MAX / sizeof(InputRun)) {
+        problem = "more input runs than steps";
+    } else if (numRuns > left / RUN_BYTES) {
+        problem = "input runs cut short";
+    } else if (!(bitsToFloat(dt) > 0) || !isfinite(bitsToFloat(dt))) {
+        problem = "step length out of range";
+    } else if (!(bitsToFloat(powerUpChance) >= 0 && bitsToFloat(powerUpChance) <= 1)) {
+        problem = "power-up chance out of range";
+    }
+    if (!problem) {
+        replay->numBricks = (int32_t)numBricks;
+        replay->dt = bitsToFloat(dt);
+        replay->extraBalls = (int32_t)extraBalls;
+        replay->powerUpChance = bitsToFloat(powerUpChance);
+        replay->solidFloor = (flags & FLAG_SOLID_FLOOR) != 0;
+        replay->randomLaunch = (flags & FLAG_RANDOM_LAUNCH) != 0;
+        replay->numRuns = replay->runCapacity = (int)numRuns;
+        replay->runs = malloc(sizeof(InputRun) * (numRuns > 0 ? numRuns : 1));
+        if (!replay->runs) {
+            problem = "out of memory";
+        }
+    }
+    uint64_t totalSteps = 0;
+    for (uint32_t r = 0; !problem && r < numRuns; ++r) {
+        uint32_t paddleDx = 0;
+        if (!readU32(file, &paddleDx) || !readU32(file, &replay->runs[r].steps)) {
+            problem = "input runs cut short";
+        } else if (replay->runs[r].steps == 0 || !isfinite(bitsToFloat(paddleDx))) {
+            problem = "invalid input run";
+        }
+        replay->runs[r].paddleDx = bitsToFloat(paddleDx);
+        totalSteps += replay->runs[r].steps;
+    }
+    if (!problem && totalSteps != replay->numSteps) {
+        problem = "input runs do not add up to the step count";
+    }
+    fclose(file);
+    if (problem) {
+        printf("Failed to load replay file %s: %s!\n", path, problem);
+        freeReplay(replay);
+        return false;
+    }
+    return true;
+}
+
+bool playReplay(const Replay *replay, GameState *state) {
+    if (!initGame(state, replay->numBricks)) {
+        return false;
+    }
+    state->seed = replay->seed;
+    state->powerUpChance = replay->powerUpChance;
+    state->solidFloor = replay->solidFloor;
+    state->randomLaunch = replay->randomLaunch;
+    resetGame(state);
+    if (replay->extraBalls > 0 && !spawnBalls(state, replay->extraBalls)) {
+        freeGame(state);
+        return false;
+    }
+
+    for (int r = 0; r < replay->numRuns; ++r) {
+        GameInput input = { replay->runs[r].paddleDx };
+        for (uint32_t s = 0; s < replay->runs[r].steps; ++s) {
+            stepGame(state, &input, replay->dt);
+        }
+    }
+    return true;
+}
+
+static const uint64_t FNV_OFFSET = 14695981039346656037ull;
+static const uint64_t FNV_PRIME = 1099511628211ull;
+
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint64_t hashU32(uint64_t hash, uint32_t value) {
+    unsigned char bytes[4] = { (unsigned char)value, (unsigned char)(value >> 8),
+                               (unsigned char)(value >> 16), (unsigned char)(value >> 24) };
+    return hashBytes(hash, bytes, 4);
+}
+
+static uint64_t hashFloat(uint64_t hash, float value) {
+    return hashU32(hash, floatBits(value));
+}
+
+uint64_t hashGameState(const GameState *state) {
+    uint64_t hash = FNV_OFFSET;
+    hash = hashU32(hash, (uint32_t)state->score);
+    hash = hashU32(hash, (uint32_t)state->gameOver | (uint32_t)state->playerWon << 1);
+    hash = hashU32(hash, state->rng);
+    hash = hashFloat(hash, state->paddle.x);
+    hash = hashFloat(hash, state->paddle.y);
+    hash = hashU32(hash, (uint32_t)state->numBalls);
+    for (int b = 0; b < state->numBalls; ++b) {
+        const Ball *ball = &state->balls[b];
+        hash = hashFloat(hash, ball->x);
+        hash = hashFloat(hash, ball->y);
+        hash = hashFloat(hash, ball->dx);
+        hash = hashFloat(hash, ball->dy);
+    }
+    for (int w = 0; w < state->bricks.numWords; ++w) {
+        hash = hashU32(hash, (uint32_t)state->bricks.active[w]);
+        hash = hashU32(hash, (uint32_t)(state->bricks.active[w] >> 32));
+    }
+    if (state->bricks.cells) {
+        hash = hashBytes(hash, state->bricks.cells, (size_t)state->bricks.count);
+    }
+    return hash;
+}
@@ -0,0 +1,59 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+// A recorded game: the settings needed to rebuild the starting state and
+// the input of every fixed step. Held input repeats for many steps, so
+// inputs are stored as runs of identical values.
+typedef struct {
+    float paddleDx;
+    uint32_t steps;
+} InputRun;
+
+typedef struct {
+    // Starting state
+    uint32_t seed;
+    int32_t numBricks;
+    float dt;            // Seconds per step
+    int32_t extraBalls;  // Balls added with spawnBalls after the reset
+    float powerUpChance;
+    bool solidFloor;
+    bool randomLaunch;
+
+    // Inputs, one run per change of input
+    InputRun *runs;
+    int numRuns;
+    int runCapacity;
+    uint64_t numSteps;
+
+    uint64_t finalHash;  // hashGameState after the last step
+} Replay;
+
+// Start a recording of a game that has just been reset (and had
+// extraBalls spawned)
+bool initReplay(Replay *replay, const GameState *state, float dt, int extraBalls);
+void freeReplay(Replay *replay);
+
+// Append the input used for one stepGame call
+bool recordStep(Replay *replay, const GameInput *input);
+
+// Store the hash of the state reached at the end of the recording
+void finishReplay(Replay *replay, const GameState *state);
+
+// Binary file I/O; false (with a message) on failure
+bool saveReplay(const Replay *replay, const char *path);
+bool loadReplay(Replay *replay, const char *path);
+
+// Rebuild the starting state in state (which initGame has not seen) and
+// play every recorded step. Free state with freeGame afterwards. Returns
+// false if the state cannot be allocated.
+bool playReplay(const Replay *replay, GameState *state);
+
+// FNV-1a over everything that decides how the game continues
+uint64_t hashGameState(const GameState *state);
+
+#endif
@@ -0,0 +1,297 @@
+#include "rewind.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+bool initRewind(RewindBuffer *rewind, int maxFrames, const GameState *state) {
+    memset(rewind, 0, sizeof(*rewind));
+    rewind->maxFrames = maxFrames > 1 ? maxFrames : 2;
+    rewind->frames = malloc(sizeof(RewindFrame) * rewind->maxFrames);
+    // Room for a few balls and changed words per frame; grown on demand
+    rewind->ballCapacity = rewind->maxFrames * 2;
+    rewind->balls = malloc(sizeof(Ball) * rewind->ballCapacity);
+    rewind->deltaCapacity = rewind->maxFrames;
+    rewind->deltas = malloc(sizeof(BrickDelta) * rewind->deltaCapacity);
+    rewind->damageCapacity = rewind->maxFrames;
+    rewind->damage = malloc(sizeof(int) * rewind->damageCapacity);
+    rewind->numWords = state->bricks.numWords;
+    rewind->lastActive = malloc(sizeof(uint64_t) * (rewind->numWords > 0 ? rewind->numWords : 1));
+    if (!rewind->frames || !rewind->balls || !rewind->deltas || !rewind->damage || !rewind->lastActive) {
+        freeRewind(rewind);
+        return false;
+    }
+    resetRewind(rewind, state);
+    return true;
+}
+
+void freeRewind(RewindBuffer *rewind) {
+    free(rewind->frames);
+    free(rewind->balls);
+    free(rewind->deltas);
+    free(rewind->damage);
+    free(rewind->lastActive);
+    memset(rewind, 0, sizeof(*rewind));
+}
+
+// Drop the oldest frame and release its ring entries
+static void dropOldestFrame(RewindBuffer *rewind) {
+    const RewindFrame *frame = &rewind->frames[rewind->firstFrame];
+    rewind->firstBall = (rewind->firstBall + frame->numBalls) % rewind->ballCapacity;
+    rewind->numBallsUsed -= frame->numBalls;
+    rewind->firstDelta = (rewind->firstDelta + frame->numDeltas) % rewind->deltaCapacity;
+    rewind->numDeltasUsed -= frame->numDeltas;
+    rewind->firstDamage = (rewind->firstDamage + frame->numDamage) % rewind->damageCapacity;
+    rewind->numDamageUsed -= frame->numDamage;
+    rewind->firstFrame = (rewind->firstFrame + 1) % rewind->maxFrames;
+    rewind->numFrames--;
+}
+
+// Enlarge a ring to hold at least needed entries, unwrapping its contents
+// to the start of the new allocation. Frame offsets (the RewindFrame field
+// at startField) are rebased to match.
+static bool growRing(void **data, size_t size, int *capacity, int *first, int used, int needed,
+                     RewindBuffer *rewind, size_t startField) {
+    int newCapacity = *capacity;
+    while (newCapacity < needed) {
+        newCapacity *= 2;
+    }
+    unsigned char *grown = malloc(size * newCapacity);
+    if (!grown) {
+        return false;
+    }
+    const unsigned char *old = *data;
+    int tail = *capacity - *first < used ? *capacity - *first : used;
+    memcpy(grown, old + size * *first, size * tail);
+    memcpy(grown + size * tail, old, size * (used - tail));
+
+    for (int f = 0; f < rewind->numFrames; ++f) {
+        RewindFrame *frame = &rewind->frames[(rewind->firstFrame + f) % rewind->maxFrames];
+        int *start = (int *)((char *)frame + startField);
+        *start = (*start - *first + *capacity) % *capacity;
+    }
+    free(*data);
+    *data = grown;
+    *capacity = newCapacity;
+    *first = 0;
+    return true;
+}
+
+// Make room for a frame with the given number of entries: drop the
+// oldest frame once the window is full, and grow a ring when the frames
+// in the window need more entries than it has (more balls in play)
+static bool reserveFrame(RewindBuffer *rewind, int numBalls, int numDeltas, int numDamage) {
+    if (rewind->numFrames == rewind->maxFrames) {
+        dropOldestFrame(rewind);
+    }
+    if (rewind->numBallsUsed + numBalls > rewind->ballCapacity &&
+        !growRing((void **)&rewind->balls, sizeof(Ball), &rewind->ballCapacity, &rewind->firstBall,
+                  rewind->numBallsUsed, rewind->numBallsUsed + numBalls, rewind, offsetof(RewindFrame, ballStart))) {
+        return false;
+    }
+    if (rewind->numDeltasUsed + numDeltas > rewind->deltaCapacity &&
+        !growRing((void **)&rewind->deltas, sizeof(BrickDelta), &rewind->deltaCapacity, &rewind->firstDelta,
+                  rewind->numDeltasUsed, rewind->numDeltasUsed + numDeltas, rewind, offsetof(RewindFrame, deltaStart))) {
+        return false;
+    }
+    if (rewind->numDamageUsed + numDamage > rewind->damageCapacity &&
+        !growRing((void **)&rewind->damage, sizeof(int), &rewind->damageCapacity, &rewind->firstDamage,
+                  rewind->numDamageUsed, rewind->numDamageUsed + numDamage, rewind, offsetof(RewindFrame, damageStart))) {
+        return false;
+    }
+    return true;
+}
+
+// Append a frame for the current state with the given brick changes and,
+// unless it starts the history, the step's hits on bricks still standing
+static bool pushFrame(RewindBuffer *rewind, const GameState *state, const BrickDelta *deltas, int numDeltas,
+                      bool withDamage) {
+    int numDamage = withDamage ? state->damage.count : 0;
+    if (!reserveFrame(rewind, state->numBalls, numDeltas, numDamage)) {
+        return false;
+    }
+
+    RewindFrame *frame = &rewind->frames[(rewind->firstFrame + rewind->numFrames) % rewind->maxFrames];
+    frame->paddle = state->paddle;
+    frame->score = state->score;
+    frame->rng = state->rng;
+    frame->gameOver = state->gameOver;
+    frame->playerWon = state->playerWon;
+
+    frame->ballStart = (rewind->firstBall + rewind->numBallsUsed) % rewind->ballCapacity;
+    frame->numBalls = state->numBalls;
+    for (int b = 0; b < state->numBalls; ++b) {
+        rewind->balls[(frame->ballStart + b) % rewind->ballCapacity] = state->balls[b];
+    }
+    rewind->numBallsUsed += state->numBalls;
+
+    frame->deltaStart = (rewind->firstDelta + rewind->numDeltasUsed) % rewind->deltaCapacity;
+    frame->numDeltas = numDeltas;
+    for (int d = 0; d < numDeltas; ++d) {
+        rewind->deltas[(frame->deltaStart + d) % rewind->deltaCapacity] = deltas[d];
+    }
+    rewind->numDeltasUsed += numDeltas;
+
+    frame->damageStart = (rewind->firstDamage + rewind->numDamageUsed) % rewind->damageCapacity;
+    frame->numDamage = numDamage;
+    for (int d = 0; d < numDamage; ++d) {
+        rewind->damage[(frame->damageStart + d) % rewind->damageCapacity] = state->damage.bricks[d];
+    }
+    rewind->numDamageUsed += numDamage;
+
+    rewind->numFrames++;
+    return true;
+}
+
+void resetRewind(RewindBuffer *rewind, const GameState *state) {
+    rewind->firstFrame = rewind->numFrames = 0;
+    rewind->firstBall = rewind->numBallsUsed = 0;
+    rewind->firstDelta = rewind->numDeltasUsed = 0;
+    rewind->firstDamage = rewind->numDamageUsed = 0;
+    memcpy(rewind->lastActive, state->bricks.active, sizeof(uint64_t) * rewind->numWords);
+    pushFrame(rewind, state, NULL, 0, false);
+}
+
+// The changes of a step from its brick events. A step only ever destroys
+// bricks, and every one is in the events. The list is cleared when the
+// state is published, so it may still hold bricks from earlier steps;
+// lastActive already has those. Needs room for MAX_BRICK_EVENTS deltas.
+static int eventDeltas(RewindBuffer *rewind, const GameState *state, BrickDelta *deltas) {
+    const BrickEvents *events = &state->brickEvents;
+    int numDeltas = 0;
+    for (int e = 0; e < events->count; ++e) {
+        int i = events->destroyed[e];
+        int w = i / 64;
+        uint64_t bit = 1ull << (i % 64);
+        if (!(rewind->lastActive[w] & bit) || isBrickActive(&state->bricks, i)) {
+            continue;
+        }
+        rewind->lastActive[w] &= ~bit;
+        // Neighbouring bricks often go together; share their word's delta
+        if (numDeltas > 0 && deltas[numDeltas - 1].word == w) {
+            deltas[numDeltas - 1].bits |= bit;
+        } else {
+            deltas[numDeltas++] = (BrickDelta){ w, bit };
+        }
+    }
+    return numDeltas;
+}
+
+// The changes found by comparing the whole mask, for when the events do
+// not say (a rebuild). Starts in *deltas (room for MAX_BRICK_EVENTS) and
+// moves to the heap when a step changes more words; -1 if that fails.
+static int scanDeltas(RewindBuffer *rewind, const GameState *state, BrickDelta **deltas) {
+    int numDeltas = 0, maxDeltas = MAX_BRICK_EVENTS;
+    for (int w = 0; w < rewind->numWords; ++w) {
+        uint64_t changed = rewind->lastActive[w] ^ state->bricks.active[w];
+        if (!changed) {
+            continue;
+        }
+        if (numDeltas == maxDeltas) {
+            BrickDelta *more = malloc(sizeof(BrickDelta) * rewind->numWords);
+            if (!more) {
+                return -1;
+            }
+            memcpy(more, *deltas, sizeof(BrickDelta) * numDeltas);
+            *deltas = more;
+            maxDeltas = rewind->numWords;
+        }
+        (*deltas)[numDeltas++] = (BrickDelta){ w, changed };
+        rewind->lastActive[w] = state->bricks.active[w];
+    }
+    return numDeltas;
+}
+
+bool captureRewind(RewindBuffer *rewind, const GameState *state) {
+    // Without every hit of the step it could not be undone
+    if (state->damage.overflow) {
+        resetRewind(rewind, state);
+        return true;
+    }
+
+    BrickDelta local[MAX_BRICK_EVENTS];
+    BrickDelta *deltas = local;
+    int numDeltas = state->brickEvents.rebuild ? scanDeltas(rewind, state, &deltas)
+                                               : eventDeltas(rewind, state, deltas);
+    if (numDeltas < 0) {
+        return false;
+    }
+    bool ok = pushFrame(rewind, state, numDeltas ? deltas : NULL, numDeltas, true);
+    if (deltas != local) {
+        free(deltas);
+    }
+    return ok;
+}
+
+bool rewindStep(RewindBuffer *rewind, GameState *state) {
+    if (rewind->numFrames < 2) {
+        return false;
+    }
+
+    // Undo the newest frame's brick changes and forget it. A brick brought
+    // back gets back the hit that destroyed it.
+    int newest = (rewind->firstFrame + rewind->numFrames - 1) % rewind->maxFrames;
+    const RewindFrame *undone = &rewind->frames[newest];
+    uint8_t *cells = state->bricks.cells;
+    for (int d = 0; d < undone->numDeltas; ++d) {
+        const BrickDelta *delta = &rewind->deltas[(undone->deltaStart + d) % rewind->deltaCapacity];
+        uint64_t bits = delta->bits;
+        while (bits) {
+            int i = delta->word * 64 + countTrailingZeros64(bits);
+            bits &= bits - 1;
+            bool active = !isBrickActive(&state->bricks, i);
+            setBrickActive(&state->bricks, i, active);
+            if (cells) {
+                cells[i] += active ? 1 : -1;
+            }
+            if (state->collisionMode == COLLIDE_GRID) {
+                if (active) {
+                    addBrickToGrid(&state->grid, &state->bricks, i);
+                } else {
+                    removeBrickFromGrid(&state->grid, &state->bricks, i);
+                }
+            }
+        }
+        rewind->lastActive[delta->word] ^= delta->bits;
+    }
+    for (int d = 0; d < undone->numDamage; ++d) {
+        cells[rewind->damage[(undone->damageStart + d) % rewind->damageCapacity]]++;
+    }
+    rewind->numBallsUsed -= undone->numBalls;
+    rewind->numDeltasUsed -= undone->numDeltas;
+    rewind->numDamageUsed -= undone->numDamage;
+    rewind->numFrames--;
+
+    // Restore everything else from the frame that is now the newest
+    const RewindFrame *frame = &rewind->frames[(newest + rewind->maxFrames - 1) % rewind->maxFrames];
+    state->paddle = frame->paddle;
+    state->paddle.prevX = state->paddle.x;  // Nothing to interpolate from
+    state->paddle.prevY = state->paddle.y;
+    state->score = frame->score;
+    state->rng = frame->rng;
+    state->gameOver = frame->gameOver;
+    state->playerWon = frame->playerWon;
+    if (!reserveBalls(state, frame->numBalls)) {
+        return false;
+    }
+    state->numBalls = frame->numBalls;
+    for (int b = 0; b < frame->numBalls; ++b) {
+        state->balls[b] = rewind->balls[(frame->ballStart + b) % rewind->ballCapacity];
+        state->balls[b].prevX = state->balls[b].x;
+        state->balls[b].prevY = state->balls[b].y;
+        state->ballHits[b].count = 0;
+        state->ballHits[b].lost = false;
+    }
+
+    // The bricks jumped, so a cached brick layer must be redrawn
+    state->brickEvents.count = 0;
+    state->brickEvents.rebuild = true;
+    return true;
+}
+
+size_t rewindMemoryUsage(const RewindBuffer *rewind) {
+    return sizeof(RewindFrame) * rewind->maxFrames +
+           sizeof(Ball) * rewind->ballCapacity +
+           sizeof(BrickDelta) * rewind->deltaCapacity +
+           sizeof(int) * rewind->damageCapacity +
+           sizeof(uint64_t) * rewind->numWords;
+}
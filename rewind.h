@@ -0,0 +1,68 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+
+// One captured step. Balls and brick changes live in the buffer's rings;
+// a frame only records where its entries start and how many there are.
+typedef struct {
+    Paddle paddle;
+    int score;
+    uint32_t rng;
+    bool gameOver, playerWon;
+    int ballStart, numBalls;
+    int deltaStart, numDeltas;  // Brick words changed since the previous frame
+    int damageStart, numDamage; // Hits taken by bricks that still stand
+} RewindFrame;
+
+// A changed 64-bit word of the brick active mask, stored as the XOR of
+// its old and new value, so the same delta undoes the change
+typedef struct {
+    int word;
+    uint64_t bits;
+} BrickDelta;
+
+// Ring buffer of the last maxFrames steps. Only the bricks that changed
+// are stored per step, so memory does not depend on the level size.
+// Capturing a step reads the changes off its brick events; only a rebuild
+// (a reset, or more events than fit) costs a pass over the active mask.
+typedef struct {
+    RewindFrame *frames;
+    int maxFrames, firstFrame, numFrames;
+
+    Ball *balls;
+    int ballCapacity, firstBall, numBallsUsed;
+
+    BrickDelta *deltas;
+    int deltaCapacity, firstDelta, numDeltasUsed;
+
+    int *damage;  // Brick indices, one per hit
+    int damageCapacity, firstDamage, numDamageUsed;
+
+    uint64_t *lastActive;  // Brick mask at the newest frame
+    int numWords;
+} RewindBuffer;
+
+bool initRewind(RewindBuffer *rewind, int maxFrames, const GameState *state);
+void freeRewind(RewindBuffer *rewind);
+
+// Forget the history and start again from the current state, e.g. after
+// resetGame
+void resetRewind(RewindBuffer *rewind, const GameState *state);
+
+// Record the state reached by the last step, before its brick events are
+// cleared; false on allocation failure. A step with more hits than the
+// game could list starts the history afresh.
+bool captureRewind(RewindBuffer *rewind, const GameState *state);
+
+// Restore the state one step back; false once the oldest frame is reached
+bool rewindStep(RewindBuffer *rewind, GameState *state);
+
+// Bytes held by the buffer
+size_t rewindMemoryUsage(const RewindBuffer *rewind);
+
+#endif
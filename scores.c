@@ -0,0 +1,131 @@
+#include "scores.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Scores waiting to be written; a power of two
+#define SCORE_QUEUE_SIZE 64
+
+typedef struct {
+    char player[MAX_PLAYER_NAME];
+    int level;
+    int score;
+    int64_t time;
+} QueuedScore;
+
+struct ScoreWriter {
+    Leaderboard *board;
+    pthread_t thread;
+
+    // Single-producer single-consumer ring: the game thread only moves
+    // tail, the writer only moves head
+    QueuedScore queue[SCORE_QUEUE_SIZE];
+    atomic_uint head, tail;
+
+    // Only used to let the writer sleep while the queue is empty
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    atomic_bool quit;
+};
+
+// Add every queued score to the board; returns false if the queue was empty
+static bool drainQueue(ScoreWriter *writer) {
+    unsigned head = atomic_load_explicit(&writer->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&writer->tail, memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+    for (; head != tail; ++head) {
+        const QueuedScore *entry = &writer->queue[head % SCORE_QUEUE_SIZE];
+        if (!addScore(writer->board, entry->player, entry->level, entry->score, entry->time)) {
+            printf("Failed to save score of %s!\n", entry->player);
+        }
+        // Free the slot right away so the game can keep queueing
+        atomic_store_explicit(&writer->head, head + 1, memory_order_release);
+    }
+    return true;
+}
+
+static void *writerMain(void *arg) {
+    ScoreWriter *writer = arg;
+    for (;;) {
+        // Scores queued while the disk was busy share one flush
+        if (drainQueue(writer)) {
+            syncLeaderboard(writer->board);
+            continue;
+        }
+        if (atomic_load(&writer->quit)) {
+            break;
+        }
+        pthread_mutex_lock(&writer->mutex);
+        while (!atomic_load(&writer->quit) &&
+               atomic_load(&writer->head) == atomic_load(&writer->tail)) {
+            pthread_cond_wait(&writer->wake, &writer->mutex);
+        }
+        pthread_mutex_unlock(&writer->mutex);
+    }
+    return NULL;
+}
+
+ScoreWriter *startScoreWriter(Leaderboard *board) {
+    ScoreWriter *writer = calloc(1, sizeof(ScoreWriter));
+    if (!writer) {
+        return NULL;
+    }
+    writer->board = board;
+    atomic_init(&writer->head, 0);
+    atomic_init(&writer->tail, 0);
+    atomic_init(&writer->quit, false);
+    pthread_mutex_init(&writer->mutex, NULL);
+    pthread_cond_init(&writer->wake, NULL);
+    if (pthread_create(&writer->thread, NULL, writerMain, writer) != 0) {
+        printf("Failed to start score writer thread!\n");
+        pthread_cond_destroy(&writer->wake);
+        pthread_mutex_destroy(&writer->mutex);
+        free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+void stopScoreWriter(ScoreWriter *writer) {
+    if (!writer) {
+        return;
+    }
+    pthread_mutex_lock(&writer->mutex);
+    atomic_store(&writer->quit, true);
+    pthread_cond_signal(&writer->wake);
+    pthread_mutex_unlock(&writer->mutex);
+    pthread_join(writer->thread, NULL);  // Writes anything still queued first
+
+    pthread_cond_destroy(&writer->wake);
+    pthread_mutex_destroy(&writer->mutex);
+    free(writer);
+}
+
+bool submitScore(ScoreWriter *writer, const char *player, int level, int score) {
+    unsigned tail = atomic_load_explicit(&writer->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&writer->head, memory_order_acquire);
+    if (tail - head == SCORE_QUEUE_SIZE) {
+        return false;
+    }
+    QueuedScore *entry = &writer->queue[tail % SCORE_QUEUE_SIZE];
+    memset(entry->player, 0, MAX_PLAYER_NAME);
+    strncpy(entry->player, player, MAX_PLAYER_NAME - 1);
+    entry->level = level;
+    entry->score = score;
+    entry->time = (int64_t)time(NULL);
+    atomic_store_explicit(&writer->tail, tail + 1, memory_order_release);
+
+    // The writer checks the queue under the mutex before sleeping, so
+    // signalling under it cannot lose the wake-up. The writer holds it
+    // only around that check, never during I/O.
+    pthread_mutex_lock(&writer->mutex);
+    pthread_cond_signal(&writer->wake);
+    pthread_mutex_unlock(&writer->mutex);
+    return true;
+}
@@ -0,0 +1,23 @@
+#ifndef SCORES_H
+#define SCORES_H
+
+#include <stdbool.h>
+
+#include "leaderboard.h"
+
+// Score persistence off the game thread. The game thread hands finished
+// games to a writer thread through a lock-free single-producer queue; the
+// writer adds them to the leaderboard and flushes it to disk.
+typedef struct ScoreWriter ScoreWriter;
+
+// The writer uses board exclusively until it is stopped
+ScoreWriter *startScoreWriter(Leaderboard *board);
+
+// Save queued scores and stop the thread
+void stopScoreWriter(ScoreWriter *writer);
+
+// Queue a finished game without blocking; false if the queue is full.
+// Must always be called from the same thread.
+bool submitScore(ScoreWriter *writer, const char *player, int level, int score);
+
+#endif
@@ -0,0 +1,284 @@
+#include "simulation.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "profiler.h"
+#include "replay.h"
+#include "rewind.h"
+
+// Longest frame time fed to the physics accumulator, so a stall (window
+// drag, breakpoint) does not trigger a burst of catch-up steps
+static const double MAX_FRAME_TIME = 0.25;
+
+struct Simulation {
+    SimulationSettings settings;
+    float dt;
+    SDL_Thread *thread;
+
+    // Simulation thread only once started
+    GameState game;
+    Replay replay;  // The recording file always holds the latest game
+    bool recording;
+    RewindBuffer rewind;
+    bool canRewind;
+    bool scoreSubmitted;  // This game is on the leaderboard; rewinding
+                          // can undo its game over, but not the entry
+
+    // Shared with the render thread
+    SnapshotBuffer snapshots;
+    PaddleControl control;  // Guarded by controlLock
+    SDL_mutex *controlLock;
+    atomic_bool quit;
+    atomic_bool rewindHeld;      // Backspace is down
+    atomic_bool restartPressed;  // R since the last simulation frame
+};
+
+// Also tears down a partly set up simulation: every part is either set
+// up or still zeroed
+static void freeSimulation(Simulation *sim) {
+    freeReplay(&sim->replay);
+    freeRewind(&sim->rewind);
+    closePaddleControl(&sim->control);
+    freeSnapshotBuffer(&sim->snapshots);
+    destroyThreadPool(sim->game.pool);
+    freeGame(&sim->game);
+    if (sim->controlLock) {
+        SDL_DestroyMutex(sim->controlLock);
+    }
+    free(sim);
+}
+
+// Record the score and recording of a game that has just ended. A game
+// goes on the leaderboard once, at its first game over, under its level.
+static void finishGame(Simulation *sim) {
+    GameState *game = &sim->game;
+    if (game->score > sim->settings.bestScore) {
+        sim->settings.bestScore = game->score;
+    }
+    // Without a writer (no leaderboard file) scores are simply not kept,
+    // nor are those of a level file without a leaderboard id
+    int level = sim->settings.level ? levelId(sim->settings.level) : 0;
+    bool scored = sim->settings.scoreWriter && (!sim->settings.level || level > 0);
+    if (scored && !sim->scoreSubmitted) {
+        sim->scoreSubmitted = true;
+        if (!submitScore(sim->settings.scoreWriter, sim->settings.playerName, level, game->score)) {
+            printf("Failed to queue score for saving!\n");
+        }
+    }
+    if (sim->recording) {
+        finishReplay(&sim->replay, game);
+        saveReplay(&sim->replay, sim->settings.recordPath);
+        sim->recording = false;
+    }
+}
+
+static void restartGame(Simulation *sim) {
+    resetGame(&sim->game);
+    sim->scoreSubmitted = false;
+    if (sim->settings.recordPath) {
+        freeReplay(&sim->replay);
+        sim->recording = initReplay(&sim->replay, &sim->game, sim->dt, 0);
+    }
+    if (sim->canRewind) {
+        resetRewind(&sim->rewind, &sim->game);
+    }
+}
+
+// Hand the state to the render thread. time is when the state is for.
+static void publishState(Simulation *sim, double time, bool rewinding) {
+    GameSnapshot *snapshot = nextSnapshot(&sim->snapshots);
+    snapshot->time = time;
+    snapshot->bestScore = sim->settings.bestScore;
+    snapshot->rewinding = rewinding;
+    if (!publishSnapshot(&sim->snapshots, &sim->game)) {
+        printf("Failed to copy game state for drawing!\n");
+    }
+}
+
+static int simulationMain(void *data) {
+    Simulation *sim = data;
+    GameState *game = &sim->game;
+    const float dt = sim->dt;
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+    Uint64 previousCounter = SDL_GetPerformanceCounter();
+    double accumulator = 0.0;
+    GameInput input = { 0 };
+
+    while (!atomic_load(&sim->quit)) {
+        Uint64 counter = SDL_GetPerformanceCounter();
+        double frameTime = (double)(counter - previousCounter) / frequency;
+        previousCounter = counter;
+        if (frameTime > MAX_FRAME_TIME) {
+            frameTime = MAX_FRAME_TIME;
+        }
+        Uint32 now = SDL_GetTicks();
+        bool changed = false;
+
+        // Reset the game when 'R' is pressed after Game Over
+        if (atomic_exchange(&sim->restartPressed, false) && game->gameOver) {
+            restartGame(sim);
+            accumulator = 0.0;
+            changed = true;
+        }
+
+        // Rewinding can undo a game over
+        bool rewinding = sim->canRewind && atomic_load(&sim->rewindHeld);
+        if (!game->gameOver || rewinding) {
+            // Run as many physics steps as the elapsed time calls for. They
+            // cover the time up to `accumulator` before now, in slices of
+            // dt, and each gets the input that was held during its slice.
+            PROFILE_BEGIN(PHASE_PHYSICS);
+            accumulator += frameTime;
+            double stepStart = now - accumulator * 1000.0;
+            while (accumulator >= dt && (!game->gameOver || rewinding)) {
+                double stepEnd = stepStart + dt * 1000.0;
+                SDL_LockMutex(sim->controlLock);
+                input.paddleDx = paddleStepInput(&sim->control, &game->paddle, stepStart, stepEnd, dt);
+                SDL_UnlockMutex(sim->controlLock);
+                stepStart = stepEnd;
+
+                if (rewinding) {
+                    if (sim->recording) {
+                        printf("Rewind used, recording stopped\n");
+                        sim->recording = false;
+                    }
+                    rewindStep(&sim->rewind, game);
+                } else {
+                    if (sim->recording) {
+                        sim->recording = recordStep(&sim->replay, &input);
+                    }
+                    stepGame(game, &input, dt);
+                    if (sim->canRewind && !captureRewind(&sim->rewind, game)) {
+                        printf("Failed to grow rewind buffer; rewind disabled\n");
+                        sim->canRewind = false;
+                        rewinding = false;
+                    }
+                    if (game->gameOver) {
+                        finishGame(sim);
+                    }
+                }
+                accumulator -= dt;
+                changed = true;
+            }
+            PROFILE_END(PHASE_PHYSICS);
+        }
+
+        if (changed) {
+            // The state is for the end of the last step's time slice
+            publishState(sim, counter / frequency - accumulator, rewinding);
+        }
+
+        // Yield the CPU briefly; steps are timed by the accumulator
+        SDL_Delay(1);
+    }
+    return 0;
+}
+
+Simulation *startSimulation(const SimulationSettings *settings) {
+    Simulation *sim = calloc(1, sizeof(Simulation));
+    if (!sim) {
+        printf("Failed to allocate game state!\n");
+        return NULL;
+    }
+    sim->settings = *settings;
+    sim->dt = 1.f / settings->physicsHz;
+    atomic_init(&sim->quit, false);
+    atomic_init(&sim->rewindHeld, false);
+    atomic_init(&sim->restartPressed, false);
+    initPaddleControl(&sim->control);
+
+    BrickStore bricks;
+    bool ready = settings->level ? initLevelBricks(settings->level, &bricks) &&
+                                   initGameWithBricks(&sim->game, &bricks)
+                                 : initGame(&sim->game, NUM_BRICKS);
+    if (!ready) {
+        printf("Failed to allocate game state!\n");
+        freeSimulation(sim);
+        return NULL;
+    }
+    if (settings->multiball) {
+        sim->game.powerUpChance = POWER_UP_CHANCE;
+        sim->game.pool = createThreadPool(0);
+    }
+    // Recordings rebuild the built-in level, so they cannot replay a level file
+    if (settings->recordPath && settings->level) {
+        printf("Recording is not supported with a level file; recording disabled\n");
+        sim->settings.recordPath = NULL;
+    }
+    sim->recording = sim->settings.recordPath && initReplay(&sim->replay, &sim->game, sim->dt, 0);
+
+    // Hold Backspace to step back through the last few seconds
+    sim->canRewind = initRewind(&sim->rewind, (int)(settings->rewindSeconds * settings->physicsHz), &sim->game);
+    if (!sim->canRewind) {
+        printf("Failed to allocate rewind buffer; rewind disabled\n");
+    }
+
+    sim->controlLock = SDL_CreateMutex();
+    if (!sim->controlLock || !initSnapshotBuffer(&sim->snapshots, &sim->game)) {
+        printf("Failed to set up the simulation thread!\n");
+        freeSimulation(sim);
+        return NULL;
+    }
+    publishState(sim, (double)SDL_GetPerformanceCounter() / SDL_GetPerformanceFrequency(), false);
+
+    sim->thread = SDL_CreateThread(simulationMain, "simulation", sim);
+    if (!sim->thread) {
+        printf("Failed to start the simulation thread! SDL_Error: %s\n", SDL_GetError());
+        freeSimulation(sim);
+        return NULL;
+    }
+    return sim;
+}
+
+void stopSimulation(Simulation *sim) {
+    if (!sim) {
+        return;
+    }
+    atomic_store(&sim->quit, true);
+    SDL_WaitThread(sim->thread, NULL);
+
+    // An unfinished game is saved as far as it got
+    if (sim->recording) {
+        finishReplay(&sim->replay, &sim->game);
+        saveReplay(&sim->replay, sim->settings.recordPath);
+    }
+    const PaddleControl *control = &sim->control;
+    if (control->latencyCount) {
+        printf("Input latency: avg %.1f ms, max %.0f ms over %d inputs\n",
+               control->latencyTotal / control->latencyCount, control->latencyMax, control->latencyCount);
+    }
+    freeSimulation(sim);
+}
+
+const GameSnapshot *latestGameSnapshot(Simulation *sim, bool *isNew) {
+    return latestSnapshot(&sim->snapshots, isNew);
+}
+
+void simulationEvent(Simulation *sim, const SDL_Event *event) {
+    SDL_LockMutex(sim->controlLock);
+    handleInputEvent(&sim->control, event);
+    SDL_UnlockMutex(sim->controlLock);
+
+    if ((event->type == SDL_KEYDOWN || event->type == SDL_KEYUP) && !event->key.repeat) {
+        if (event->key.keysym.sym == SDLK_BACKSPACE) {
+            atomic_store(&sim->rewindHeld, event->type == SDL_KEYDOWN);
+        }
+        if (event->key.keysym.sym == SDLK_r && event->type == SDL_KEYDOWN) {
+            atomic_store(&sim->restartPressed, true);
+        }
+    }
+}
+
+void pollSimulationInput(Simulation *sim) {
+    SDL_LockMutex(sim->controlLock);
+    pollPaddleControl(&sim->control, SDL_GetTicks());
+    SDL_UnlockMutex(sim->controlLock);
+}
+
+void simulationPresented(Simulation *sim) {
+    SDL_LockMutex(sim->controlLock);
+    inputPresented(&sim->control, SDL_GetTicks());
+    SDL_UnlockMutex(sim->controlLock);
+}
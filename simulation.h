@@ -0,0 +1,48 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+#include "input.h"
+#include "level.h"
+#include "scores.h"
+#include "snapshot.h"
+
+// The game simulation on its own thread. It runs fixed physics steps on
+// its own clock, so a slow frame or present on the render thread does not
+// hold physics back, and publishes a snapshot after every batch of steps.
+// Recording, rewinding and saving scores happen on this thread too.
+typedef struct {
+    int physicsHz;
+    bool multiball;
+    const char *recordPath;  // Save each game's inputs for replay, or NULL
+    float rewindSeconds;     // History kept for rewinding
+    ScoreWriter *scoreWriter;
+    const char *playerName;
+    int bestScore;
+    const Level *level;      // Bricks of a level file, or NULL for the built-in level
+} SimulationSettings;
+
+typedef struct Simulation Simulation;
+
+// Set up the game and start the thread; NULL (with a message) on failure
+Simulation *startSimulation(const SimulationSettings *settings);
+
+// Stop the thread, save an unfinished recording and free everything
+void stopSimulation(Simulation *sim);
+
+// Render thread: the newest snapshot; see latestSnapshot
+const GameSnapshot *latestGameSnapshot(Simulation *sim, bool *isNew);
+
+// Render thread: pass on an SDL event. Handles the paddle controls,
+// Backspace (rewind) and R (restart after a game over).
+void simulationEvent(Simulation *sim, const SDL_Event *event);
+
+// Render thread: sample the input devices once the events are handled
+void pollSimulationInput(Simulation *sim);
+
+// Render thread: a frame has been presented (for the input latency figures)
+void simulationPresented(Simulation *sim);
+
+#endif
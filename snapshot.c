@@ -0,0 +1,191 @@
+#include "snapshot.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Set in middle while the reader has not taken that slot yet
+#define SNAPSHOT_FRESH 4u
+
+// Copy the brick geometry and active mask. A level file's geometry never
+// changes and a lattice has none stored, so only the mask is copied then.
+static bool copyBricks(BrickStore *to, const BrickStore *from) {
+    bool share = from->borrowed;
+    bool lattice = from->lattice.cols > 0;
+    if (to->count != from->count || to->borrowed != share || (to->lattice.cols > 0) != lattice ||
+        (share && to->x != from->x)) {
+        freeBrickStore(to);
+        bool ok;
+        if (lattice) {
+            ok = initBrickLattice(to, from->count, &from->lattice);
+        } else if (share) {
+            ok = initBrickStoreView(to, from->count, from->x, from->y, from->width, from->height);
+        } else {
+            ok = initBrickStore(to, from->count);
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    if (lattice) {
+        to->lattice = from->lattice;
+    } else if (!share) {
+        size_t size = sizeof(int32_t) * from->count;
+        memcpy(to->x, from->x, size);
+        memcpy(to->y, from->y, size);
+        memcpy(to->width, from->width, size);
+        memcpy(to->height, from->height, size);
+    }
+    memcpy(to->active, from->active, sizeof(uint64_t) * from->numWords);
+    to->liveCount = from->liveCount;
+    // Level data is read-only and outlives the game; the renderer has no
+    // use for the cells
+    to->colors = from->colors;
+    return true;
+}
+
+// Copy the state except the brick events
+static bool copyState(GameSnapshot *snapshot, const GameState *state, unsigned brickVersion) {
+    if (snapshot->ballCapacity < state->numBalls) {
+        Ball *balls = realloc(snapshot->balls, sizeof(Ball) * state->ballCapacity);
+        if (!balls) {
+            return false;
+        }
+        snapshot->balls = balls;
+        snapshot->ballCapacity = state->ballCapacity;
+    }
+    memcpy(snapshot->balls, state->balls, sizeof(Ball) * state->numBalls);
+    snapshot->numBalls = state->numBalls;
+    snapshot->paddle = state->paddle;
+    snapshot->score = state->score;
+    snapshot->gameOver = state->gameOver;
+    snapshot->playerWon = state->playerWon;
+
+    // The layout only changes on a rebuild; otherwise only the mask moves
+    if (snapshot->brickVersion != brickVersion || snapshot->bricks.count != state->bricks.count) {
+        if (!copyBricks(&snapshot->bricks, &state->bricks)) {
+            return false;
+        }
+        snapshot->brickVersion = brickVersion;
+    } else {
+        memcpy(snapshot->bricks.active, state->bricks.active, sizeof(uint64_t) * state->bricks.numWords);
+        snapshot->bricks.liveCount = state->bricks.liveCount;
+    }
+    return true;
+}
+
+bool initSnapshotBuffer(SnapshotBuffer *buffer, const GameState *state) {
+    memset(buffer, 0, sizeof(*buffer));
+    for (int s = 0; s < 3; ++s) {
+        if (!copyState(&buffer->slots[s], state, 0)) {
+            freeSnapshotBuffer(buffer);
+            return false;
+        }
+        buffer->slots[s].brickEvents.rebuild = true;
+        buffer->slots[s].eventsStart = 0;
+        buffer->slots[s].eventsEnd = 1;
+    }
+    // Sequence number 0 is the rebuild every slot starts with
+    buffer->eventSequence = 1;
+    buffer->pendingStart = 1;
+    buffer->publishedEnd = 1;
+    buffer->front = 0;
+    buffer->back = 1;
+    atomic_init(&buffer->middle, 2u);
+    return true;
+}
+
+void freeSnapshotBuffer(SnapshotBuffer *buffer) {
+    for (int s = 0; s < 3; ++s) {
+        free(buffer->slots[s].balls);
+        freeBrickStore(&buffer->slots[s].bricks);
+    }
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+GameSnapshot *nextSnapshot(SnapshotBuffer *buffer) {
+    return &buffer->slots[buffer->back];
+}
+
+// Add a step's events to the pending list and number them. A rebuild, or
+// more events than fit, replaces the list with a rebuild of its own.
+static void appendEvents(SnapshotBuffer *buffer, const BrickEvents *from) {
+    BrickEvents *to = &buffer->pending;
+    if (!to->rebuild && to->count == 0) {
+        buffer->pendingStart = buffer->eventSequence;
+    }
+    if (from->rebuild || to->count + from->count > MAX_BRICK_EVENTS) {
+        to->rebuild = true;
+        to->count = 0;
+        buffer->pendingStart = buffer->eventSequence++;
+        return;
+    }
+    memcpy(&to->destroyed[to->count], from->destroyed, sizeof(int) * from->count);
+    to->count += from->count;
+    buffer->eventSequence += from->count;
+}
+
+// Drop the events numbered below consumed from a list starting at *start
+static void dropConsumedEvents(BrickEvents *events, uint64_t *start, uint64_t consumed) {
+    if (consumed <= *start) {
+        return;
+    }
+    uint64_t skip = consumed - *start;
+    if (events->rebuild) {
+        events->rebuild = false;
+        ++*start;
+        --skip;
+    }
+    if (skip > (uint64_t)events->count) {
+        skip = events->count;
+    }
+    events->count -= (int)skip;
+    memmove(events->destroyed, &events->destroyed[skip], sizeof(int) * events->count);
+    *start += skip;
+}
+
+bool publishSnapshot(SnapshotBuffer *buffer, GameState *state) {
+    if (state->brickEvents.rebuild) {
+        ++buffer->brickVersion;
+    }
+    GameSnapshot *snapshot = &buffer->slots[buffer->back];
+    if (!copyState(snapshot, state, buffer->brickVersion)) {
+        return false;
+    }
+    appendEvents(buffer, &state->brickEvents);
+    snapshot->brickEvents.count = buffer->pending.count;
+    snapshot->brickEvents.rebuild = buffer->pending.rebuild;
+    memcpy(snapshot->brickEvents.destroyed, buffer->pending.destroyed, sizeof(int) * buffer->pending.count);
+    snapshot->eventsStart = buffer->pendingStart;
+    snapshot->eventsEnd = buffer->eventSequence;
+
+    uint64_t previousEnd = buffer->publishedEnd;
+    buffer->publishedEnd = snapshot->eventsEnd;
+    unsigned previous = atomic_exchange_explicit(&buffer->middle, (unsigned)buffer->back | SNAPSHOT_FRESH,
+                                                 memory_order_acq_rel);
+    buffer->back = (int)(previous & 3u);
+
+    // If the reader took the previous snapshot it has seen every event up
+    // to that one's end; the rest are still unseen
+    if (!(previous & SNAPSHOT_FRESH)) {
+        dropConsumedEvents(&buffer->pending, &buffer->pendingStart, previousEnd);
+    }
+    clearBrickEvents(state);
+    return true;
+}
+
+const GameSnapshot *latestSnapshot(SnapshotBuffer *buffer, bool *isNew) {
+    *isNew = false;
+    if (atomic_load_explicit(&buffer->middle, memory_order_relaxed) & SNAPSHOT_FRESH) {
+        unsigned previous = atomic_exchange_explicit(&buffer->middle, (unsigned)buffer->front,
+                                                     memory_order_acq_rel);
+        buffer->front = (int)(previous & 3u);
+        *isNew = true;
+
+        // The snapshot may repeat events of one taken earlier: its events
+        // were chosen before the publisher knew that one had been taken
+        GameSnapshot *snapshot = &buffer->slots[buffer->front];
+        dropConsumedEvents(&snapshot->brickEvents, &snapshot->eventsStart, buffer->consumedEvents);
+        buffer->consumedEvents = snapshot->eventsEnd;
+    }
+    return &buffer->slots[buffer->front];
+}
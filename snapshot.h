@@ -0,0 +1,71 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+// What the renderer needs from the state after a physics step. Once
+// published a snapshot is never written again until the renderer has
+// moved on from it.
+typedef struct {
+    Paddle paddle;
+    Ball *balls;
+    int numBalls, ballCapacity;
+    BrickStore bricks;          // Own copy: geometry and active mask
+    unsigned brickVersion;      // Layout the geometry was copied from
+    BrickEvents brickEvents;    // Destroyed since the renderer's last snapshot
+    // Sequence numbers of the events: a rebuild takes eventsStart and the
+    // destroyed bricks follow, otherwise destroyed[0] is eventsStart
+    uint64_t eventsStart, eventsEnd;
+    int score;
+    bool gameOver, playerWon;
+
+    // Filled in by the publisher
+    double time;      // When the state is for, in seconds
+    int bestScore;
+    bool rewinding;
+} GameSnapshot;
+
+// Triple buffer between one publishing and one reading thread: the
+// publisher fills its back slot and swaps it with the middle one, the
+// reader swaps the middle slot with its front slot when a newer one is
+// there. Neither side ever waits for the other.
+typedef struct {
+    GameSnapshot slots[3];
+    atomic_uint middle;  // Middle slot index, with SNAPSHOT_FRESH if unread
+    int back;            // Publisher's slot
+    int front;           // Reader's slot
+
+    // Brick events published since the reader last took a snapshot; each
+    // new snapshot carries them all, so skipped snapshots lose nothing.
+    // Every event and rebuild gets a sequence number, and the reader drops
+    // the ones it has already seen, so none is delivered twice.
+    BrickEvents pending;
+    uint64_t pendingStart;    // Sequence number of the first pending event
+    uint64_t eventSequence;   // Next sequence number
+    uint64_t publishedEnd;    // eventsEnd of the snapshot in the middle slot
+    uint64_t consumedEvents;  // Reader: events delivered so far
+    unsigned brickVersion;    // Bumped whenever the brick layout is rebuilt
+} SnapshotBuffer;
+
+// Every slot starts as a copy of state
+bool initSnapshotBuffer(SnapshotBuffer *buffer, const GameState *state);
+void freeSnapshotBuffer(SnapshotBuffer *buffer);
+
+// Publisher: the slot the next publishSnapshot writes, for the fields the
+// publisher fills in
+GameSnapshot *nextSnapshot(SnapshotBuffer *buffer);
+
+// Publisher: copy state into the back slot and make it the latest.
+// Consumes the state's brick events. False if balls could not be copied.
+bool publishSnapshot(SnapshotBuffer *buffer, GameState *state);
+
+// Reader: the newest published snapshot. isNew tells whether it differs
+// from the one returned last time. Its brick events are those the reader
+// has not been given before, each exactly once.
+const GameSnapshot *latestSnapshot(SnapshotBuffer *buffer, bool *isNew);
+
+#endif
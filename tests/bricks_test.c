@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bricks.h"
+
+// Every overlap kernel must find exactly the bricks the scalar one finds,
+// in the same order, including when the output fills up and the query is
+// continued; a lattice must match the same bricks stored explicitly
+
+#define TEST_BRICKS 1003  // Not a multiple of BRICK_BLOCK
+#define TEST_QUERIES 2000
+#define MAX_FOUND TEST_BRICKS
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+// Deterministic, so a failure can be reproduced
+static uint32_t testRandom(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static float randomCoord(uint32_t *state, int range) {
+    return (float)(testRandom(state) % (range * 4)) / 4.f - 50.f;
+}
+
+// Every overlapping brick, gathered maxOut at a time
+static int findAll(const BrickStore *store, const float box[4], int maxOut, int *found) {
+    int count = 0, first = 0;
+    int page[MAX_FOUND];
+    for (;;) {
+        int n = findOverlappingBricks(store, first, box[0], box[1], box[2], box[3], page, maxOut);
+        memcpy(&found[count], page, sizeof(int) * n);
+        count += n;
+        if (n < maxOut) {
+            return count;
+        }
+        first = page[n - 1] + 1;
+    }
+}
+
+// Compare each kernel the CPU has with the scalar one on the same queries
+static void compareKernels(const BrickStore *store, uint32_t seed) {
+    static const char *const kernels[] = { "sse2", "avx2" };
+    static int expected[TEST_QUERIES][MAX_FOUND], expectedCount[TEST_QUERIES];
+    static int found[MAX_FOUND];
+    static const int pageSizes[] = { 1, 7, MAX_FOUND };
+    float boxes[TEST_QUERIES][4];
+
+    for (int q = 0; q < TEST_QUERIES; ++q) {
+        float x = randomCoord(&seed, 900), y = randomCoord(&seed, 700);
+        float w = (float)(testRandom(&seed) % 400) / 3.f, h = (float)(testRandom(&seed) % 300) / 3.f;
+        boxes[q][0] = x;
+        boxes[q][1] = y;
+        boxes[q][2] = x + w;
+        boxes[q][3] = y + h;
+    }
+    CHECK(selectBrickKernel("scalar"));
+    for (int q = 0; q < TEST_QUERIES; ++q) {
+        expectedCount[q] = findAll(store, boxes[q], MAX_FOUND, expected[q]);
+    }
+
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k) {
+        if (!selectBrickKernel(kernels[k])) {
+            printf("%s kernel not supported here, skipped\n", kernels[k]);
+            continue;
+        }
+        for (int q = 0; q < TEST_QUERIES; ++q) {
+            for (size_t p = 0; p < sizeof(pageSizes) / sizeof(pageSizes[0]); ++p) {
+                int count = findAll(store, boxes[q], pageSizes[p], found);
+                CHECK(count == expectedCount[q]);
+                CHECK(memcmp(found, expected[q], sizeof(int) * (count < expectedCount[q] ? count : expectedCount[q])) == 0);
+            }
+        }
+    }
+    selectBrickKernel(NULL);
+}
+
+// Overlapping bricks of random sizes, some destroyed
+static void testRandomBricks(void) {
+    BrickStore store;
+    CHECK(initBrickStore(&store, TEST_BRICKS));
+    uint32_t seed = 12345;
+    for (int i = 0; i < TEST_BRICKS; ++i) {
+        store.x[i] = (int32_t)(testRandom(&seed) % 1000) - 50;
+        store.y[i] = (int32_t)(testRandom(&seed) % 800) - 50;
+        store.width[i] = 1 + (int32_t)(testRandom(&seed) % 120);
+        store.height[i] = 1 + (int32_t)(testRandom(&seed) % 40);
+    }
+    activateAllBricks(&store);
+    for (int i = 0; i < TEST_BRICKS; ++i) {
+        if (testRandom(&seed) % 4 == 0) {
+            setBrickActive(&store, i, false);
+        }
+    }
+    compareKernels(&store, 777);
+    freeBrickStore(&store);
+}
+
+// A lattice answers like the same bricks with explicit geometry
+static void testLattice(void) {
+    BrickLattice lattice = { 37, 15, 15, 25, 17, 20, 12 };
+    BrickStore grid, explicitStore;
+    CHECK(initBrickLattice(&grid, TEST_BRICKS, &lattice));
+    CHECK(initBrickStore(&explicitStore, TEST_BRICKS));
+    uint32_t seed = 99;
+    for (int i = 0; i < TEST_BRICKS; ++i) {
+        explicitStore.x[i] = brickX(&grid, i);
+        explicitStore.y[i] = brickY(&grid, i);
+        explicitStore.width[i] = brickWidth(&grid, i);
+        explicitStore.height[i] = brickHeight(&grid, i);
+    }
+    activateAllBricks(&explicitStore);
+    for (int i = 0; i < TEST_BRICKS; ++i) {
+        if (testRandom(&seed) % 3 == 0) {
+            setBrickActive(&grid, i, false);
+            setBrickActive(&explicitStore, i, false);
+        }
+    }
+    CHECK(grid.liveCount == explicitStore.liveCount);
+
+    int expected[MAX_FOUND], found[MAX_FOUND];
+    for (int q = 0; q < TEST_QUERIES; ++q) {
+        float x = randomCoord(&seed, 1000), y = randomCoord(&seed, 800);
+        float box[4] = { x, y, x + (float)(testRandom(&seed) % 200) / 3.f, y + (float)(testRandom(&seed) % 100) / 3.f };
+        int expectedCount = findAll(&explicitStore, box, MAX_FOUND, expected);
+        int count = findAll(&grid, box, 5, found);
+        CHECK(count == expectedCount);
+        CHECK(memcmp(found, expected, sizeof(int) * (count < expectedCount ? count : expectedCount)) == 0);
+    }
+    freeBrickStore(&grid);
+    freeBrickStore(&explicitStore);
+}
+
+int main(void) {
+    testRandomBricks();
+    testLattice();
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("brick tests passed\n");
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "leaderboard.h"
+
+// The leaderboard must answer from its indexes after a reopen, rebuild
+// indexes that were left half written or damaged, and refuse files that
+// are cut short or not leaderboards at all
+
+#define TEST_PATH "leaderboard_test.dat"
+#define TEST_GAMES 600
+#define TEST_PLAYERS 20
+#define TEST_LEVELS 5
+
+// Header fields, as laid out in leaderboard.c
+#define DIRTY_OFFSET 12
+#define PLAYER_INDEX_OFFSET 56
+#define TOP_OFFSET 72
+#define RECORD_OFFSET 80
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+static int best[TEST_LEVELS];
+static int playerBests[TEST_PLAYERS][TEST_LEVELS];
+
+static void playerName(int p, char *name) {
+    sprintf(name, "player%d", p);
+}
+
+static void addGames(void) {
+    remove(TEST_PATH);
+    Leaderboard *board = openLeaderboard(TEST_PATH);
+    CHECK(board != NULL);
+    if (!board) {
+        return;
+    }
+    uint32_t seed = 5;
+    for (int g = 0; g < TEST_GAMES; ++g) {
+        seed = seed * 1664525u + 1013904223u;
+        int p = (int)(seed >> 8) % TEST_PLAYERS, level = g % TEST_LEVELS, score = (int)(seed >> 20) % 1000 + 1;
+        char name[MAX_PLAYER_NAME];
+        playerName(p, name);
+        CHECK(addScore(board, name, level, score, 1000 + g));
+        best[level] = score > best[level] ? score : best[level];
+        playerBests[p][level] = score > playerBests[p][level] ? score : playerBests[p][level];
+    }
+    closeLeaderboard(board);
+}
+
+// Open the file and check every query against what was added
+static void checkBoard(void) {
+    Leaderboard *board = openLeaderboard(TEST_PATH);
+    CHECK(board != NULL);
+    if (!board) {
+        return;
+    }
+    CHECK(leaderboardSize(board) == TEST_GAMES);
+    for (int level = 0; level < TEST_LEVELS; ++level) {
+        CHECK(leaderboardBest(board, level) == best[level]);
+        ScoreEntry top[LEADERBOARD_TOP];
+        int count = topScores(board, level, top, LEADERBOARD_TOP);
+        CHECK(count == LEADERBOARD_TOP);
+        for (int t = 1; t < count; ++t) {
+            CHECK(top[t].score <= top[t - 1].score && top[t].level == level);
+        }
+        for (int p = 0; p < TEST_PLAYERS; ++p) {
+            char name[MAX_PLAYER_NAME];
+            playerName(p, name);
+            ScoreEntry entry;
+            bool found = playerBest(board, name, level, &entry);
+            CHECK(found == (playerBests[p][level] > 0));
+            CHECK(!found || entry.score == playerBests[p][level]);
+        }
+    }
+    closeLeaderboard(board);
+}
+
+static unsigned char *readFile(size_t *size) {
+    FILE *file = fopen(TEST_PATH, "rb");
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char *bytes = malloc(*size);
+    if (bytes && fread(bytes, 1, *size, file) != *size) {
+        free(bytes);
+        bytes = NULL;
+    }
+    fclose(file);
+    return bytes;
+}
+
+static void writeFile(const unsigned char *bytes, size_t size) {
+    FILE *file = fopen(TEST_PATH, "wb");
+    CHECK(file && fwrite(bytes, 1, size, file) == size);
+    if (file) {
+        fclose(file);
+    }
+}
+
+static uint64_t headerOffset(const unsigned char *bytes, size_t field) {
+    uint64_t offset;
+    memcpy(&offset, bytes + field, sizeof(offset));
+    return offset;
+}
+
+static void testDamagedIndexes(void) {
+    size_t size;
+    unsigned char *bytes = readFile(&size);
+    CHECK(bytes != NULL);
+    if (!bytes) {
+        return;
+    }
+    uint64_t indexStart = headerOffset(bytes, PLAYER_INDEX_OFFSET);
+    uint64_t topStart = headerOffset(bytes, TOP_OFFSET);
+    uint64_t recordStart = headerOffset(bytes, RECORD_OFFSET);
+    CHECK(indexStart < topStart && topStart < recordStart && recordStart <= size);
+
+    // Garbage in every index: found on open and rebuilt
+    unsigned char *damaged = malloc(size);
+    memcpy(damaged, bytes, size);
+    memset(damaged + indexStart, 0xFF, recordStart - indexStart);
+    writeFile(damaged, size);
+    checkBoard();
+
+    // A game that stopped while adding a score, with the top tables cleared
+    memcpy(damaged, bytes, size);
+    uint32_t dirty = 1;
+    memcpy(damaged + DIRTY_OFFSET, &dirty, sizeof(dirty));
+    memset(damaged + topStart, 0, recordStart - topStart);
+    writeFile(damaged, size);
+    checkBoard();
+
+    // Cut short, or not a leaderboard
+    writeFile(bytes, 50);
+    CHECK(openLeaderboard(TEST_PATH) == NULL);
+    writeFile(bytes, (size_t)recordStart + 24);
+    CHECK(openLeaderboard(TEST_PATH) == NULL);
+    memcpy(damaged, bytes, size);
+    damaged[0] = 'X';
+    writeFile(damaged, size);
+    CHECK(openLeaderboard(TEST_PATH) == NULL);
+
+    free(damaged);
+    free(bytes);
+}
+
+int main(void) {
+    addGames();
+    checkBoard();
+    testDamagedIndexes();
+    remove(TEST_PATH);
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("leaderboard tests passed\n");
+    return 0;
+}
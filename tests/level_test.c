@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "level.h"
+
+// Level files must load back as written, explicit or on a lattice, and
+// openLevel must turn away damaged ones instead of using them in place
+
+#define TEST_BRICKS 50
+#define TEST_PATH "level_test.lvl"
+#define DAMAGED_PATH "level_test_damaged.lvl"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+typedef struct {
+    int32_t x[TEST_BRICKS], y[TEST_BRICKS], width[TEST_BRICKS], height[TEST_BRICKS];
+    uint8_t cells[TEST_BRICKS];
+    uint32_t colors[TEST_BRICKS];
+} TestBricks;
+
+// Ten bricks a row, every fifth hard with three hits and one unbreakable
+static void makeBricks(TestBricks *bricks, LevelData *data) {
+    for (int i = 0; i < TEST_BRICKS; ++i) {
+        bricks->x[i] = 15 + i % 10 * 70;
+        bricks->y[i] = 15 + i / 10 * 30;
+        bricks->width[i] = 60;
+        bricks->height[i] = 20;
+        bricks->cells[i] = i % 5 == 0 ? brickCell(BRICK_HARD, 3) : brickCell(BRICK_NORMAL, 1);
+        bricks->colors[i] = 0x10203000u | (uint32_t)i;
+    }
+    bricks->cells[7] = brickCell(BRICK_UNBREAKABLE, 1);
+    *data = (LevelData){
+        TEST_BRICKS, bricks->x, bricks->y, bricks->width, bricks->height, bricks->cells, bricks->colors, 9, NULL
+    };
+}
+
+// Open path and check its bricks against what was written
+static void checkLevel(const char *path, const TestBricks *bricks, bool lattice) {
+    Level *level = openLevel(path);
+    CHECK(level != NULL);
+    if (!level) {
+        return;
+    }
+    CHECK(levelBrickCount(level) == TEST_BRICKS);
+    CHECK(levelId(level) == 9);
+    BrickStore store;
+    CHECK(initLevelBricks(level, &store));
+    CHECK((store.lattice.cols > 0) == lattice);
+    CHECK(store.liveCount == TEST_BRICKS && store.unbreakable == 1);
+    CHECK(store.cells && memcmp(store.cells, bricks->cells, TEST_BRICKS) == 0);
+    CHECK(memcmp(store.colors, bricks->colors, sizeof(bricks->colors)) == 0);
+    for (int i = 0; i < TEST_BRICKS; ++i) {
+        CHECK(brickX(&store, i) == bricks->x[i] && brickY(&store, i) == bricks->y[i]);
+        CHECK(brickWidth(&store, i) == bricks->width[i] && brickHeight(&store, i) == bricks->height[i]);
+    }
+    freeBrickStore(&store);
+    closeLevel(level);
+}
+
+static void testRoundTrip(void) {
+    TestBricks bricks;
+    LevelData data;
+    makeBricks(&bricks, &data);
+    CHECK(saveLevel(TEST_PATH, &data));
+    checkLevel(TEST_PATH, &bricks, false);
+
+    BrickLattice lattice = { 10, 15, 15, 70, 30, 60, 20 };
+    data.lattice = &lattice;
+    CHECK(saveLevel(TEST_PATH, &data));
+    checkLevel(TEST_PATH, &bricks, true);
+
+    // Overlapping lattice bricks are refused when saving
+    BrickLattice overlapping = { 10, 15, 15, 50, 30, 60, 20 };
+    data.lattice = &overlapping;
+    CHECK(!saveLevel(DAMAGED_PATH, &data));
+}
+
+// Save data to DAMAGED_PATH and expect openLevel to refuse it
+static void checkRejected(const LevelData *data) {
+    CHECK(saveLevel(DAMAGED_PATH, data));
+    Level *level = openLevel(DAMAGED_PATH);
+    CHECK(level == NULL);
+    closeLevel(level);
+}
+
+static void testInvalidBricks(void) {
+    TestBricks bricks;
+    LevelData data;
+    makeBricks(&bricks, &data);
+    bricks.x[3] = MAX_LEVEL_COORD + 1;
+    checkRejected(&data);
+    makeBricks(&bricks, &data);
+    bricks.height[49] = 0;
+    checkRejected(&data);
+    makeBricks(&bricks, &data);
+    bricks.cells[20] = brickCell(BRICK_HARD, 0);
+    checkRejected(&data);
+    makeBricks(&bricks, &data);
+    bricks.cells[21] = brickCell(BRICK_UNBREAKABLE + 1, 1);
+    checkRejected(&data);
+}
+
+static void testDamagedFiles(void) {
+    TestBricks bricks;
+    LevelData data;
+    BrickLattice lattice = { 10, 15, 15, 70, 30, 60, 20 };
+    makeBricks(&bricks, &data);
+    for (int pass = 0; pass < 2; ++pass) {
+        data.lattice = pass ? &lattice : NULL;
+        CHECK(saveLevel(TEST_PATH, &data));
+        FILE *file = fopen(TEST_PATH, "rb");
+        CHECK(file != NULL);
+        if (!file) {
+            return;
+        }
+        fseek(file, 0, SEEK_END);
+        size_t size = (size_t)ftell(file);
+        fseek(file, 0, SEEK_SET);
+        unsigned char *bytes = malloc(size);
+        CHECK(bytes && fread(bytes, 1, size, file) == size);
+        fclose(file);
+
+        // Cut short anywhere
+        for (size_t cut = 0; cut < size; cut += cut < 256 ? 1 : 61) {
+            FILE *damaged = fopen(DAMAGED_PATH, "wb");
+            CHECK(damaged && fwrite(bytes, 1, cut, damaged) == cut);
+            fclose(damaged);
+            Level *level = openLevel(DAMAGED_PATH);
+            CHECK(level == NULL);
+            closeLevel(level);
+        }
+
+        // Any header byte changed to garbage: either refused or still a
+        // level whose bricks are in bounds
+        for (size_t offset = 0; offset < 128 && offset < size; ++offset) {
+            unsigned char saved = bytes[offset];
+            bytes[offset] ^= 0xA5;
+            FILE *damaged = fopen(DAMAGED_PATH, "wb");
+            CHECK(damaged && fwrite(bytes, 1, size, damaged) == size);
+            fclose(damaged);
+            bytes[offset] = saved;
+            Level *level = openLevel(DAMAGED_PATH);
+            if (level) {
+                BrickStore store;
+                CHECK(initLevelBricks(level, &store));
+                for (int i = 0; i < store.count; ++i) {
+                    int32_t x = brickX(&store, i), y = brickY(&store, i);
+                    CHECK(x >= -MAX_LEVEL_COORD && x <= MAX_LEVEL_COORD);
+                    CHECK(y >= -MAX_LEVEL_COORD && y <= MAX_LEVEL_COORD);
+                    CHECK(brickWidth(&store, i) >= 1 && brickHeight(&store, i) >= 1);
+                }
+                freeBrickStore(&store);
+                closeLevel(level);
+            }
+        }
+        free(bytes);
+    }
+}
+
+int main(void) {
+    testRoundTrip();
+    testInvalidBricks();
+    testDamagedFiles();
+    remove(TEST_PATH);
+    remove(DAMAGED_PATH);
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("level tests passed\n");
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "autopilot.h"
+#include "replay.h"
+
+// A saved recording must load back unchanged and replay to the hash it
+// stores; damaged files must be rejected by loadReplay, not played
+
+#define TEST_STEPS 3000
+#define TEST_PATH "replay_test.rep"
+#define DAMAGED_PATH "replay_test_damaged.rep"
+
+// Header fields, as laid out in replay.c
+#define POWER_UP_OFFSET 24
+#define NUM_RUNS_OFFSET 48
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+// Play a multiball game with the autopilot and record it to TEST_PATH
+static bool recordGame(Replay *replay) {
+    GameState state;
+    if (!initGame(&state, NUM_BRICKS)) {
+        return false;
+    }
+    state.seed = 42;
+    state.powerUpChance = 0.3f;
+    state.randomLaunch = true;
+    resetGame(&state);
+    bool ok = spawnBalls(&state, 3) && initReplay(replay, &state, 1.f / PHYSICS_HZ, 3);
+    for (int s = 0; ok && s < TEST_STEPS && !state.gameOver; ++s) {
+        GameInput input = autopilotInput(AUTOPILOT_TRACK, &state);
+        ok = recordStep(replay, &input);
+        stepGame(&state, &input, replay->dt);
+    }
+    if (ok) {
+        finishReplay(replay, &state);
+        ok = saveReplay(replay, TEST_PATH);
+    }
+    freeGame(&state);
+    return ok;
+}
+
+static uint64_t replayHash(const Replay *replay) {
+    GameState state;
+    if (!playReplay(replay, &state)) {
+        return 0;
+    }
+    uint64_t hash = hashGameState(&state);
+    freeGame(&state);
+    return hash;
+}
+
+static void testRoundTrip(const Replay *recorded) {
+    Replay loaded;
+    CHECK(loadReplay(&loaded, TEST_PATH));
+    CHECK(loaded.seed == recorded->seed && loaded.numBricks == recorded->numBricks);
+    CHECK(loaded.dt == recorded->dt && loaded.extraBalls == recorded->extraBalls);
+    CHECK(loaded.powerUpChance == recorded->powerUpChance);
+    CHECK(loaded.solidFloor == recorded->solidFloor && loaded.randomLaunch == recorded->randomLaunch);
+    CHECK(loaded.numSteps == recorded->numSteps && loaded.finalHash == recorded->finalHash);
+    CHECK(loaded.numRuns == recorded->numRuns);
+    if (loaded.numRuns == recorded->numRuns) {
+        CHECK(memcmp(loaded.runs, recorded->runs, sizeof(InputRun) * loaded.numRuns) == 0);
+    }
+    CHECK(replayHash(&loaded) == loaded.finalHash);
+
+    // A different input must end in a different state
+    CHECK(loaded.numRuns > 1);
+    loaded.runs[loaded.numRuns / 2].paddleDx = -loaded.runs[loaded.numRuns / 2].paddleDx;
+    CHECK(replayHash(&loaded) != loaded.finalHash);
+    freeReplay(&loaded);
+}
+
+static unsigned char *readFile(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char *bytes = malloc(*size);
+    if (bytes && fread(bytes, 1, *size, file) != *size) {
+        free(bytes);
+        bytes = NULL;
+    }
+    fclose(file);
+    return bytes;
+}
+
+static void writeFile(const char *path, const unsigned char *bytes, size_t size) {
+    FILE *file = fopen(path, "wb");
+    CHECK(file && fwrite(bytes, 1, size, file) == size);
+    if (file) {
+        fclose(file);
+    }
+}
+
+static void putU32(unsigned char *bytes, size_t offset, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        bytes[offset + i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+// Write bytes with one field changed and expect the load to fail
+static void checkRejected(const unsigned char *bytes, size_t size, size_t offset, uint32_t value) {
+    unsigned char *damaged = malloc(size);
+    memcpy(damaged, bytes, size);
+    putU32(damaged, offset, value);
+    writeFile(DAMAGED_PATH, damaged, size);
+    Replay replay;
+    CHECK(!loadReplay(&replay, DAMAGED_PATH));
+    free(damaged);
+}
+
+static void testDamagedFiles(void) {
+    size_t size;
+    unsigned char *bytes = readFile(TEST_PATH, &size);
+    CHECK(bytes != NULL);
+    if (!bytes) {
+        return;
+    }
+    Replay replay;
+
+    // Cut short anywhere, header or runs
+    for (size_t cut = 0; cut < size; cut += cut < 64 ? 1 : 8) {
+        writeFile(DAMAGED_PATH, bytes, cut);
+        CHECK(!loadReplay(&replay, DAMAGED_PATH));
+    }
+
+    float nan = nanf("");
+    float outOfRange[] = { -0.5f, 1.5f, nan, INFINITY };
+    for (size_t i = 0; i < sizeof(outOfRange) / sizeof(outOfRange[0]); ++i) {
+        uint32_t bits;
+        memcpy(&bits, &outOfRange[i], sizeof(bits));
+        checkRejected(bytes, size, POWER_UP_OFFSET, bits);
+    }
+    checkRejected(bytes, size, 0, 0);  // Magic
+    checkRejected(bytes, size, NUM_RUNS_OFFSET, 0x7FFFFFFF);
+    checkRejected(bytes, size, NUM_RUNS_OFFSET, (uint32_t)(size - NUM_RUNS_OFFSET - 4) / 8 + 1);
+    free(bytes);
+    remove(DAMAGED_PATH);
+}
+
+int main(void) {
+    Replay recorded;
+    if (!recordGame(&recorded)) {
+        printf("Failed to record a game!\n");
+        return 1;
+    }
+    testRoundTrip(&recorded);
+    testDamagedFiles();
+    freeReplay(&recorded);
+    remove(TEST_PATH);
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("replay tests passed\n");
+    return 0;
+}
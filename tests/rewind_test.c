@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "level.h"
+#include "rewind.h"
+
+// Rewinding must bring back exactly the brick mask, score and brick hits
+// of every earlier step, whether or not the brick events were cleared in
+// between and after the history wraps around
+
+#define TEST_STEPS 1500
+#define TEST_FRAMES 1000  // Fewer than the steps, so the oldest are dropped
+#define TEST_PATH "rewind_test.lvl"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+typedef struct {
+    uint64_t *active;
+    uint8_t *cells;
+    int score;
+} SavedStep;
+
+// Step with many balls, saving every state, then rewind and compare
+static void checkRewind(GameState *state) {
+    RewindBuffer rewind;
+    CHECK(initRewind(&rewind, TEST_FRAMES, state));
+    size_t maskSize = sizeof(uint64_t) * state->bricks.numWords;
+    int count = state->bricks.count;
+    SavedStep *saved = calloc(TEST_STEPS + 1, sizeof(SavedStep));
+    int steps = 0;
+    for (int s = 0; s <= TEST_STEPS; ++s) {
+        if (s > 0) {
+            GameInput input = { (float)(s / 37 % 3 - 1) };
+            stepGame(state, &input, 1.f / PHYSICS_HZ);
+            CHECK(captureRewind(&rewind, state));
+            CHECK(memcmp(rewind.lastActive, state->bricks.active, maskSize) == 0);
+            // The renderer clears the events only now and then
+            if (s % 3 == 0) {
+                clearBrickEvents(state);
+            }
+        }
+        saved[s].active = malloc(maskSize);
+        memcpy(saved[s].active, state->bricks.active, maskSize);
+        if (state->bricks.cells) {
+            saved[s].cells = malloc(count);
+            memcpy(saved[s].cells, state->bricks.cells, count);
+        }
+        saved[s].score = state->score;
+        steps = s;
+        if (state->gameOver) {
+            break;
+        }
+    }
+    CHECK(saved[steps].score > 0);
+
+    // Back to the oldest step still held, and no further
+    int held = steps < TEST_FRAMES - 1 ? steps : TEST_FRAMES - 1;
+    for (int back = 1; back <= held; ++back) {
+        CHECK(rewindStep(&rewind, state));
+        const SavedStep *expected = &saved[steps - back];
+        CHECK(memcmp(state->bricks.active, expected->active, maskSize) == 0);
+        CHECK(state->score == expected->score);
+        CHECK(!expected->cells || memcmp(state->bricks.cells, expected->cells, count) == 0);
+    }
+    CHECK(!rewindStep(&rewind, state));
+
+    for (int s = 0; s <= steps; ++s) {
+        free(saved[s].active);
+        free(saved[s].cells);
+    }
+    free(saved);
+    freeRewind(&rewind);
+}
+
+static void testBuiltInLevel(void) {
+    GameState state;
+    CHECK(initGame(&state, 2000));
+    state.randomLaunch = true;
+    resetGame(&state);
+    CHECK(spawnBalls(&state, 40));
+    clearBrickEvents(&state);
+    checkRewind(&state);
+    freeGame(&state);
+}
+
+// Bricks that take several hits and unbreakable ones get their hits back
+static void testHitPoints(void) {
+    enum { COLS = 12, ROWS = 6, COUNT = COLS * ROWS };
+    uint8_t cells[COUNT];
+    for (int i = 0; i < COUNT; ++i) {
+        cells[i] = i % 7 == 0 ? brickCell(BRICK_UNBREAKABLE, 1) : brickCell(BRICK_HARD, 1 + i % 4);
+    }
+    BrickLattice lattice = { COLS, 15, 15, 65, 25, 60, 20 };
+    LevelData data = { COUNT, NULL, NULL, NULL, NULL, cells, NULL, 0, &lattice };
+    CHECK(saveLevel(TEST_PATH, &data));
+    Level *level = openLevel(TEST_PATH);
+    CHECK(level != NULL);
+    if (!level) {
+        return;
+    }
+    BrickStore bricks;
+    GameState state;
+    CHECK(initLevelBricks(level, &bricks));
+    CHECK(initGameWithBricks(&state, &bricks));
+    state.randomLaunch = true;
+    resetGame(&state);
+    CHECK(spawnBalls(&state, 20));
+    clearBrickEvents(&state);
+    checkRewind(&state);
+    freeGame(&state);
+    closeLevel(level);
+    remove(TEST_PATH);
+}
+
+int main(void) {
+    testBuiltInLevel();
+    testHitPoints();
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("rewind tests passed\n");
+    return 0;
+}
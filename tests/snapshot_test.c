@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "snapshot.h"
+
+// Brick events must reach the reader exactly once, whether it takes every
+// snapshot or skips some
+
+#define TEST_BRICKS 20
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+// Publish one step that destroyed the given brick
+static void publishEvent(SnapshotBuffer *buffer, GameState *state, int brick) {
+    state->brickEvents.count = 1;
+    state->brickEvents.destroyed[0] = brick;
+    state->brickEvents.rebuild = false;
+    CHECK(publishSnapshot(buffer, state));
+}
+
+// Read the newest snapshot and count how often each brick was delivered
+static const GameSnapshot *readEvents(SnapshotBuffer *buffer, int *delivered) {
+    bool isNew;
+    const GameSnapshot *snapshot = latestSnapshot(buffer, &isNew);
+    if (isNew) {
+        for (int e = 0; e < snapshot->brickEvents.count; ++e) {
+            delivered[snapshot->brickEvents.destroyed[e]]++;
+        }
+    }
+    return snapshot;
+}
+
+static void testLockstep(GameState *state) {
+    SnapshotBuffer buffer;
+    CHECK(initSnapshotBuffer(&buffer, state));
+    int delivered[TEST_BRICKS] = { 0 };
+    const GameSnapshot *first = readEvents(&buffer, delivered);
+    CHECK(first->brickEvents.rebuild);
+    for (int b = 0; b < TEST_BRICKS; ++b) {
+        publishEvent(&buffer, state, b);
+        const GameSnapshot *snapshot = readEvents(&buffer, delivered);
+        CHECK(snapshot->brickEvents.count == 1 && snapshot->brickEvents.destroyed[0] == b);
+        CHECK(!snapshot->brickEvents.rebuild);
+    }
+    for (int b = 0; b < TEST_BRICKS; ++b) {
+        CHECK(delivered[b] == 1);
+    }
+    freeSnapshotBuffer(&buffer);
+}
+
+// The reader takes a snapshot after every few publishes
+static void testSkippedSnapshots(GameState *state) {
+    SnapshotBuffer buffer;
+    CHECK(initSnapshotBuffer(&buffer, state));
+    int delivered[TEST_BRICKS] = { 0 };
+    readEvents(&buffer, delivered);
+    for (int b = 0; b < TEST_BRICKS; ++b) {
+        publishEvent(&buffer, state, b);
+        if (b % 3 == 2) {
+            readEvents(&buffer, delivered);
+        }
+    }
+    readEvents(&buffer, delivered);
+    for (int b = 0; b < TEST_BRICKS; ++b) {
+        CHECK(delivered[b] == 1);
+    }
+    freeSnapshotBuffer(&buffer);
+}
+
+// A rebuild is delivered once, and the events after it still arrive
+static void testRebuild(GameState *state) {
+    SnapshotBuffer buffer;
+    CHECK(initSnapshotBuffer(&buffer, state));
+    int delivered[TEST_BRICKS] = { 0 };
+    readEvents(&buffer, delivered);
+
+    state->brickEvents.count = 0;
+    state->brickEvents.rebuild = true;
+    CHECK(publishSnapshot(&buffer, state));
+    CHECK(readEvents(&buffer, delivered)->brickEvents.rebuild);
+    publishEvent(&buffer, state, 4);
+    const GameSnapshot *snapshot = readEvents(&buffer, delivered);
+    CHECK(!snapshot->brickEvents.rebuild);
+    CHECK(delivered[4] == 1);
+    freeSnapshotBuffer(&buffer);
+}
+
+int main(void) {
+    GameState state;
+    if (!initGame(&state, TEST_BRICKS)) {
+        printf("Failed to initialize the game!\n");
+        return 1;
+    }
+    clearBrickEvents(&state);
+    testLockstep(&state);
+    testSkippedSnapshots(&state);
+    testRebuild(&state);
+    freeGame(&state);
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("snapshot tests passed\n");
+    return 0;
+}
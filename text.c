@@ -0,0 +1,133 @@
+#include "text.h"
+
+#include <stdio.h>
+
+// Width of the atlas texture; rows are added as needed
+static const int ATLAS_WIDTH = 512;
+
+// Rasterize every printable glyph and pack them row by row into one texture
+bool createGlyphAtlas(GlyphAtlas *atlas, SDL_Renderer *renderer, TTF_Font *font) {
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface *surfaces[NUM_GLYPHS] = { NULL };
+    bool ok = false;
+
+    atlas->renderer = renderer;
+    atlas->texture = NULL;
+    atlas->numQuads = 0;
+
+    // Render glyphs and lay them out
+    int penX = 0, penY = 0, rowHeight = 0;
+    for (int i = 0; i < NUM_GLYPHS; ++i) {
+        Uint16 ch = (Uint16)(FIRST_GLYPH + i);
+        int advance = 0;
+        TTF_GlyphMetrics(font, ch, NULL, NULL, NULL, NULL, &advance);
+        atlas->glyphs[i].advance = advance;
+        atlas->glyphs[i].src = (SDL_Rect){ 0, 0, 0, 0 };
+
+        surfaces[i] = TTF_RenderGlyph_Blended(font, ch, white);
+        if (!surfaces[i]) {
+            continue; // Glyph missing from the font; it will be skipped
+        }
+        if (penX + surfaces[i]->w > ATLAS_WIDTH) {
+            penX = 0;
+            penY += rowHeight + 1;
+            rowHeight = 0;
+        }
+        atlas->glyphs[i].src = (SDL_Rect){ penX, penY, surfaces[i]->w, surfaces[i]->h };
+        penX += surfaces[i]->w + 1;
+        if (surfaces[i]->h > rowHeight) {
+            rowHeight = surfaces[i]->h;
+        }
+    }
+
+    // Copy glyphs into one surface and upload it
+    SDL_Surface *sheet = SDL_CreateRGBSurfaceWithFormat(0, ATLAS_WIDTH, penY + rowHeight, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!sheet) {
+        printf("Failed to create glyph atlas surface! SDL_Error: %s\n", SDL_GetError());
+        goto cleanup;
+    }
+    SDL_FillRect(sheet, NULL, 0);
+    for (int i = 0; i < NUM_GLYPHS; ++i) {
+        if (surfaces[i]) {
+            SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(surfaces[i], NULL, sheet, &atlas->glyphs[i].src);
+        }
+    }
+    atlas->texture = SDL_CreateTextureFromSurface(renderer, sheet);
+    if (!atlas->texture) {
+        printf("Failed to create glyph atlas texture! SDL_Error: %s\n", SDL_GetError());
+        SDL_FreeSurface(sheet);
+        goto cleanup;
+    }
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    atlas->textureWidth = (float)sheet->w;
+    atlas->textureHeight = (float)sheet->h;
+    SDL_FreeSurface(sheet);
+
+    // Every quad uses the same two triangles, so indices never change
+    for (int q = 0; q < MAX_TEXT_QUADS; ++q) {
+        int *index = &atlas->indices[q * 6];
+        int base = q * 4;
+        index[0] = base;
+        index[1] = base + 1;
+        index[2] = base + 2;
+        index[3] = base + 2;
+        index[4] = base + 3;
+        index[5] = base;
+    }
+    ok = true;
+
+cleanup:
+    for (int i = 0; i < NUM_GLYPHS; ++i) {
+        SDL_FreeSurface(surfaces[i]);
+    }
+    return ok;
+}
+
+void destroyGlyphAtlas(GlyphAtlas *atlas) {
+    if (atlas->texture) {
+        SDL_DestroyTexture(atlas->texture);
+        atlas->texture = NULL;
+    }
+}
+
+// Function to display text
+void displayText(GlyphAtlas *atlas, const char *text, SDL_Color color, int x, int y) {
+    float penX = (float)x;
+    for (const char *c = text; *c; ++c) {
+        int ch = (unsigned char)*c;
+        if (ch < FIRST_GLYPH || ch > LAST_GLYPH) {
+            continue;
+        }
+        const Glyph *glyph = &atlas->glyphs[ch - FIRST_GLYPH];
+        if (glyph->src.w > 0) {
+            if (atlas->numQuads == MAX_TEXT_QUADS) {
+                flushText(atlas);
+            }
+            float x0 = penX, y0 = (float)y;
+            float x1 = x0 + glyph->src.w, y1 = y0 + glyph->src.h;
+            float u0 = glyph->src.x / atlas->textureWidth;
+            float v0 = glyph->src.y / atlas->textureHeight;
+            float u1 = (glyph->src.x + glyph->src.w) / atlas->textureWidth;
+            float v1 = (glyph->src.y + glyph->src.h) / atlas->textureHeight;
+
+            SDL_Vertex *v = &atlas->vertices[atlas->numQuads * 4];
+            v[0] = (SDL_Vertex){ { x0, y0 }, color, { u0, v0 } };
+            v[1] = (SDL_Vertex){ { x1, y0 }, color, { u1, v0 } };
+            v[2] = (SDL_Vertex){ { x1, y1 }, color, { u1, v1 } };
+            v[3] = (SDL_Vertex){ { x0, y1 }, color, { u0, v1 } };
+            atlas->numQuads++;
+        }
+        penX += glyph->advance;
+    }
+}
+
+// Submit all queued text in a single draw call
+void flushText(GlyphAtlas *atlas) {
+    if (atlas->numQuads > 0) {
+        SDL_RenderGeometry(atlas->renderer, atlas->texture,
+                           atlas->vertices, atlas->numQuads * 4,
+                           atlas->indices, atlas->numQuads * 6);
+        atlas->numQuads = 0;
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <stdbool.h>
+
+// Printable ASCII range baked into the atlas
+#define FIRST_GLYPH 32
+#define LAST_GLYPH 126
+#define NUM_GLYPHS (LAST_GLYPH - FIRST_GLYPH + 1)
+
+// Characters drawn per batch before an automatic flush
+#define MAX_TEXT_QUADS 512
+
+typedef struct {
+    SDL_Rect src;  // Location in the atlas texture
+    int advance;   // Horizontal pen advance
+} Glyph;
+
+// All printable glyphs of one font rasterized once into a single texture.
+// Text is queued as quads and submitted with one SDL_RenderGeometry call.
+typedef struct {
+    SDL_Renderer *renderer;
+    SDL_Texture *texture;
+    float textureWidth, textureHeight;
+    Glyph glyphs[NUM_GLYPHS];
+    SDL_Vertex vertices[MAX_TEXT_QUADS * 4];
+    int indices[MAX_TEXT_QUADS * 6];
+    int numQuads;
+} GlyphAtlas;
+
+bool createGlyphAtlas(GlyphAtlas *atlas, SDL_Renderer *renderer, TTF_Font *font);
+void destroyGlyphAtlas(GlyphAtlas *atlas);
+
+// Queue text at (x, y); nothing reaches the renderer until flushText
+void displayText(GlyphAtlas *atlas, const char *text, SDL_Color color, int x, int y);
+
+// Submit all queued text in a single draw call
+void flushText(GlyphAtlas *atlas);
+
+#endif
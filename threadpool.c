@@ -0,0 +1,181 @@
+#include "threadpool.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+struct ThreadPool {
+    pthread_t *threads;
+    int numThreads;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;      // Signalled when a new loop starts
+    pthread_cond_t finished;  // Signalled when the last worker leaves a loop
+    unsigned generation;      // Incremented per loop so workers see new work
+    int busyWorkers;          // Workers that have not finished the current loop
+    bool quit;
+
+    // Current loop; only written while no worker is busy
+    ParallelTask task;
+    void *context;
+    int count, grain, numChunks;
+    atomic_int nextChunk;
+};
+
+typedef struct {
+    ThreadPool *pool;
+    int worker;
+} WorkerStart;
+
+int hardwareThreads(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+// Claim chunks of the current loop until none are left
+static void runChunks(ThreadPool *pool, int worker) {
+    for (;;) {
+        int chunk = atomic_fetch_add(&pool->nextChunk, 1);
+        if (chunk >= pool->numChunks) {
+            return;
+        }
+        int begin = chunk * pool->grain;
+        int end = begin + pool->grain < pool->count ? begin + pool->grain : pool->count;
+        pool->task(pool->context, begin, end, worker);
+    }
+}
+
+static void *workerMain(void *arg) {
+    WorkerStart start = *(WorkerStart *)arg;
+    ThreadPool *pool = start.pool;
+    free(arg);
+
+    unsigned seen = 0;
+    pthread_mutex_lock(&pool->mutex);
+    for (;;) {
+        while (!pool->quit && pool->generation == seen) {
+            pthread_cond_wait(&pool->wake, &pool->mutex);
+        }
+        if (pool->quit) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->mutex);
+        runChunks(pool, start.worker);
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->busyWorkers == 0) {
+            pthread_cond_signal(&pool->finished);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+ThreadPool *createThreadPool(int numThreads) {
+    if (numThreads <= 0) {
+        numThreads = hardwareThreads();
+    }
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    if (!pool) {
+        return NULL;
+    }
+    pool->numThreads = numThreads;
+    pool->threads = calloc(numThreads, sizeof(pthread_t));
+    if (!pool->threads) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->finished, NULL);
+    atomic_init(&pool->nextChunk, 0);
+
+    // Worker 0 is the thread that calls parallelFor
+    for (int i = 1; i < numThreads; ++i) {
+        WorkerStart *start = malloc(sizeof(WorkerStart));
+        if (!start) {
+            pool->numThreads = i;
+            break;
+        }
+        start->pool = pool;
+        start->worker = i;
+        if (pthread_create(&pool->threads[i], NULL, workerMain, start) != 0) {
+            free(start);
+            pool->numThreads = i;
+            break;
+        }
+    }
+    return pool;
+}
+
+void destroyThreadPool(ThreadPool *pool) {
+    if (!pool) {
+        return;
+    }
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+    for (int i = 1; i < pool->numThreads; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->finished);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->threads);
+    free(pool);
+}
+
+int threadPoolSize(const ThreadPool *pool) {
+    return pool ? pool->numThreads : 1;
+}
+
+// Split [0, count) into chunks of grain items and run them across the pool
+void parallelFor(ThreadPool *pool, int count, int grain, ParallelTask task, void *context) {
+    if (count <= 0) {
+        return;
+    }
+    if (grain < 1) {
+        grain = 1;
+    }
+    int numChunks = (count + grain - 1) / grain;
+    if (!pool || pool->numThreads == 1 || numChunks == 1) {
+        task(context, 0, count, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->task = task;
+    pool->context = context;
+    pool->count = count;
+    pool->grain = grain;
+    pool->numChunks = numChunks;
+    atomic_store(&pool->nextChunk, 0);
+    pool->busyWorkers = pool->numThreads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+
+    runChunks(pool, 0);
+
+    // Wait for every worker, not just every chunk, so none is still
+    // reading this loop's fields when the next one is set up
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->busyWorkers > 0) {
+        pthread_cond_wait(&pool->finished, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
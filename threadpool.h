@@ -0,0 +1,23 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+// Fixed set of worker threads for data-parallel loops. The calling thread
+// takes part in every loop, so a pool of N threads starts N - 1 workers.
+typedef struct ThreadPool ThreadPool;
+
+// Run task over [begin, end); worker is in [0, threadPoolSize)
+typedef void (*ParallelTask)(void *context, int begin, int end, int worker);
+
+// numThreads <= 0 uses one thread per hardware thread
+ThreadPool *createThreadPool(int numThreads);
+void destroyThreadPool(ThreadPool *pool);
+int threadPoolSize(const ThreadPool *pool);
+
+// Hardware threads available to this process
+int hardwareThreads(void);
+
+// Split [0, count) into chunks of grain items, run them across the pool
+// and return once all are done. pool may be NULL to run inline.
+void parallelFor(ThreadPool *pool, int count, int grain, ParallelTask task, void *context);
+
+#endif
@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "level.h"
+
+// Converts a text level to the binary level format. One brick per line:
+//     x y width height [hitPoints [type [colour]]]
+// with the colour as hex RRGGBB or RRGGBBAA. Blank lines and lines
+// starting with # are ignored. Lines are read one at a time, so only the
+// brick arrays are held in memory. Bricks laid out in rows of equal
+// bricks, left to right and top to bottom, are written as a lattice.
+
+typedef struct {
+    int count, capacity;
+    int32_t *x, *y, *width, *height;
+    uint8_t *cells;
+    uint32_t *colors;
+} BrickList;
+
+static bool growArray(void **array, size_t entrySize, int capacity) {
+    void *grown = realloc(*array, entrySize * capacity);
+    if (!grown) {
+        return false;
+    }
+    *array = grown;
+    return true;
+}
+
+static bool growBrickList(BrickList *list) {
+    int capacity = list->capacity ? list->capacity * 2 : 1024;
+    if (!growArray((void **)&list->x, sizeof(int32_t), capacity) ||
+        !growArray((void **)&list->y, sizeof(int32_t), capacity) ||
+        !growArray((void **)&list->width, sizeof(int32_t), capacity) ||
+        !growArray((void **)&list->height, sizeof(int32_t), capacity) ||
+        !growArray((void **)&list->cells, sizeof(uint8_t), capacity) ||
+        !growArray((void **)&list->colors, sizeof(uint32_t), capacity)) {
+        return false;
+    }
+    list->capacity = capacity;
+    return true;
+}
+
+static void freeBrickList(BrickList *list) {
+    free(list->x);
+    free(list->y);
+    free(list->width);
+    free(list->height);
+    free(list->cells);
+    free(list->colors);
+}
+
+static bool addBrick(BrickList *list, int x, int y, int width, int height, int hitPoints, int type,
+                     uint32_t color) {
+    if (list->count == MAX_LEVEL_BRICKS) {
+        printf("A level holds at most %d bricks!\n", MAX_LEVEL_BRICKS);
+        return false;
+    }
+    if (list->count == list->capacity && !growBrickList(list)) {
+        printf("Failed to allocate bricks!\n");
+        return false;
+    }
+    int i = list->count++;
+    list->x[i] = x;
+    list->y[i] = y;
+    list->width[i] = width;
+    list->height[i] = height;
+    list->cells[i] = brickCell(type, hitPoints);
+    list->colors[i] = color;
+    return true;
+}
+
+// Parse RRGGBB or RRGGBBAA
+static bool parseColor(const char *text, uint32_t *color) {
+    size_t length = strlen(text);
+    char *end;
+    unsigned long value = strtoul(text, &end, 16);
+    if (*end != '\0' || (length != 6 && length != 8)) {
+        return false;
+    }
+    *color = length == 6 ? (uint32_t)value << 8 | 0xFF : (uint32_t)value;
+    return true;
+}
+
+static bool readTextLevel(const char *path, BrickList *list) {
+    FILE *file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!file) {
+        printf("Failed to open %s!\n", path);
+        return false;
+    }
+    char line[256];
+    int lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        ++lineNumber;
+        char *text = line + strspn(line, " \t");
+        if (*text == '#' || *text == '\n' || *text == '\r' || *text == '\0') {
+            continue;
+        }
+        int x, y, width, height, hitPoints = 1, type = BRICK_NORMAL;
+        char colorText[16] = "FF0000";
+        uint32_t color;
+        int fields = sscanf(text, "%d %d %d %d %d %d %15s", &x, &y, &width, &height, &hitPoints, &type, colorText);
+        if (fields < 4 || width <= 0 || height <= 0 || hitPoints < 1 || hitPoints > MAX_BRICK_HITS ||
+            type < BRICK_NORMAL || type > BRICK_UNBREAKABLE || !parseColor(colorText, &color)) {
+            printf("%s:%d: expected x y width height [hitPoints [type [RRGGBB[AA]]]]\n", path, lineNumber);
+            ok = false;
+        } else if (x < -MAX_LEVEL_COORD || x > MAX_LEVEL_COORD || y < -MAX_LEVEL_COORD || y > MAX_LEVEL_COORD ||
+                   width > MAX_LEVEL_COORD || height > MAX_LEVEL_COORD) {
+            printf("%s:%d: positions and sizes must be within %d\n", path, lineNumber, MAX_LEVEL_COORD);
+            ok = false;
+        } else {
+            ok = addBrick(list, x, y, width, height, hitPoints, type, color);
+        }
+    }
+    if (file != stdin) {
+        fclose(file);
+    }
+    return ok;
+}
+
+// The built-in layout continued for cols x rows bricks, for stress tests
+static bool makeGrid(BrickList *list, int cols, int rows) {
+    if (cols < 1 || rows < 1 || (long long)cols * rows > MAX_LEVEL_BRICKS) {
+        printf("--grid needs 1 to %d bricks!\n", MAX_LEVEL_BRICKS);
+        return false;
+    }
+    // The last brick's position, worked out where it cannot overflow
+    if ((long long)(cols - 1) * (BRICK_WIDTH + 5) + 15 > MAX_LEVEL_COORD ||
+        (long long)(rows - 1) * (BRICK_HEIGHT + 5) + 15 > MAX_LEVEL_COORD) {
+        printf("--grid bricks must lie within %d pixels!\n", MAX_LEVEL_COORD);
+        return false;
+    }
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            uint32_t color = (uint32_t)(255 - r % 128) << 24 | (uint32_t)(c * 255 / cols) << 16 | 0xFF;
+            if (!addBrick(list, c * (BRICK_WIDTH + 5) + 15, r * (BRICK_HEIGHT + 5) + 15,
+                          BRICK_WIDTH, BRICK_HEIGHT, 1, BRICK_NORMAL, color)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Whether the bricks sit on a lattice, in index order: the first row is
+// the bricks level with brick 0, and every brick must be where the
+// lattice puts it
+static bool findLattice(const BrickList *list, BrickLattice *lattice) {
+    if (list->count == 0) {
+        return false;
+    }
+    int cols = 1;
+    while (cols < list->count && list->y[cols] == list->y[0]) {
+        ++cols;
+    }
+    *lattice = (BrickLattice){
+        cols, list->x[0], list->y[0],
+        cols > 1 ? list->x[1] - list->x[0] : list->width[0],
+        cols < list->count ? list->y[cols] - list->y[0] : list->height[0],
+        list->width[0], list->height[0]
+    };
+    if (lattice->width > lattice->pitchX || lattice->height > lattice->pitchY) {
+        return false;
+    }
+    BrickStore placed = { .lattice = *lattice };
+    for (int i = 0; i < list->count; ++i) {
+        if (list->x[i] != brickX(&placed, i) || list->y[i] != brickY(&placed, i) ||
+            list->width[i] != lattice->width || list->height[i] != lattice->height) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void printUsage(const char *program) {
+    printf("usage: %s [--id N] INPUT.txt OUTPUT.lvl\n"
+           "       %s [--id N] --grid COLS ROWS OUTPUT.lvl\n"
+           "  INPUT.txt      one brick per line: x y width height [hitPoints [type [RRGGBB[AA]]]]\n"
+           "                 with hitPoints 1 to %d and type 0 (normal), 1 (hard) or\n"
+           "                 2 (unbreakable); - reads standard input\n"
+           "  --grid C R     C x R bricks laid out like the built-in level\n"
+           "  --id N         keep the level's scores as leaderboard level N (1 to %d);\n"
+           "                 without an id its games are not scored\n",
+           program, program, MAX_BRICK_HITS, MAX_LEVEL_ID);
+}
+
+int main(int argc, char* argv[])
+{
+    BrickList list = { 0 };
+    bool ok;
+    const char *outputPath;
+    const char *program = argv[0];
+    int id = 0;
+    if (argc >= 3 && strcmp(argv[1], "--id") == 0) {
+        id = atoi(argv[2]);
+        argc -= 2;
+        argv += 2;
+        if (id < 1 || id > MAX_LEVEL_ID) {
+            printf("--id needs a level from 1 to %d!\n", MAX_LEVEL_ID);
+            return 1;
+        }
+    }
+    if (argc == 5 && strcmp(argv[1], "--grid") == 0) {
+        ok = makeGrid(&list, atoi(argv[2]), atoi(argv[3]));
+        outputPath = argv[4];
+    } else if (argc == 3) {
+        ok = readTextLevel(argv[1], &list);
+        outputPath = argv[2];
+    } else {
+        printUsage(program);
+        return 1;
+    }
+
+    if (ok) {
+        BrickLattice lattice;
+        bool regular = findLattice(&list, &lattice);
+        LevelData data = {
+            list.count, list.x, list.y, list.width, list.height, list.cells, list.colors, id,
+            regular ? &lattice : NULL
+        };
+        ok = saveLevel(outputPath, &data);
+        if (ok && regular) {
+            printf("%s: %d bricks on a lattice of %d columns\n", outputPath, list.count, lattice.cols);
+        } else if (ok) {
+            printf("%s: %d bricks\n", outputPath, list.count);
+        }
+    }
+    freeBrickList(&list);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+#include "tournament.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "threadpool.h"
+
+static bool initResult(TournamentResult *result, int numBricks) {
+    memset(result, 0, sizeof(*result));
+    result->numBricks = numBricks;
+    result->scoreHistogram = calloc((size_t)numBricks + 1, sizeof(long));
+    return result->scoreHistogram != NULL;
+}
+
+void freeTournamentResult(TournamentResult *result) {
+    free(result->scoreHistogram);
+    result->scoreHistogram = NULL;
+}
+
+typedef struct {
+    const TournamentSettings *settings;
+    Autopilot autopilot;
+    long maxSteps;
+    GameState *games;             // One per worker
+    TournamentResult *partials;   // One per worker, merged at the end
+} TournamentTask;
+
+// Play games [begin, end) on the worker's own game state
+static void playGames(void *context, int begin, int end, int worker) {
+    const TournamentTask *task = context;
+    const TournamentSettings *settings = task->settings;
+    GameState *game = &task->games[worker];
+    TournamentResult *result = &task->partials[worker];
+    for (int g = begin; g < end; ++g) {
+        game->seed = settings->firstSeed + (uint32_t)g;
+        resetGame(game);
+        long steps = 0;
+        while (!game->gameOver && steps < task->maxSteps) {
+            GameInput input = autopilotInput(task->autopilot, game);
+            stepGame(game, &input, settings->dt);
+            ++steps;
+        }
+
+        float time = steps * settings->dt;
+        int bucket = (int)(time / settings->maxGameTime * TOURNAMENT_LENGTH_BUCKETS);
+        result->lengthHistogram[bucket < TOURNAMENT_LENGTH_BUCKETS ? bucket : TOURNAMENT_LENGTH_BUCKETS - 1]++;
+        int score = game->score < result->numBricks ? game->score : result->numBricks;
+        result->scoreHistogram[score]++;
+        result->games++;
+        result->wins += game->playerWon;
+        result->timeouts += !game->gameOver;
+        result->totalScore += game->score;
+        result->totalTime += time;
+        result->totalSteps += steps;
+    }
+}
+
+// A worker's game on the tournament's level
+static bool initWorkerGame(GameState *game, const TournamentSettings *settings) {
+    if (!settings->level) {
+        return initGame(game, settings->numBricks);
+    }
+    BrickStore bricks;
+    return initLevelBricks(settings->level, &bricks) && initGameWithBricks(game, &bricks);
+}
+
+bool runTournament(const TournamentSettings *settings, Autopilot autopilot, TournamentResult *result) {
+    int numBricks = settings->level ? levelBrickCount(settings->level) : settings->numBricks;
+    if (!initResult(result, numBricks)) {
+        printf("Failed to allocate tournament results!\n");
+        return false;
+    }
+    ThreadPool *pool = createThreadPool(settings->numThreads);
+    int numWorkers = pool ? threadPoolSize(pool) : 0;
+    TournamentTask task = { settings, autopilot, (long)ceilf(settings->maxGameTime / settings->dt), NULL, NULL };
+    task.games = calloc(numWorkers, sizeof(GameState));
+    task.partials = calloc(numWorkers, sizeof(TournamentResult));
+    int ready = 0;
+    if (pool && task.games && task.partials) {
+        for (; ready < numWorkers; ++ready) {
+            if (!initWorkerGame(&task.games[ready], settings)) {
+                break;
+            }
+            if (!initResult(&task.partials[ready], numBricks)) {
+                freeGame(&task.games[ready]);
+                break;
+            }
+            task.games[ready].powerUpChance = settings->powerUpChance;
+            task.games[ready].randomLaunch = true;
+        }
+    }
+
+    bool ok = pool && ready == numWorkers;
+    if (ok) {
+        // One game per chunk: game lengths vary too much for larger ones
+        parallelFor(pool, settings->numGames, 1, playGames, &task);
+        for (int w = 0; w < numWorkers; ++w) {
+            const TournamentResult *partial = &task.partials[w];
+            result->games += partial->games;
+            result->wins += partial->wins;
+            result->timeouts += partial->timeouts;
+            result->totalScore += partial->totalScore;
+            result->totalTime += partial->totalTime;
+            result->totalSteps += partial->totalSteps;
+            for (int s = 0; s <= numBricks; ++s) {
+                result->scoreHistogram[s] += partial->scoreHistogram[s];
+            }
+            for (int b = 0; b < TOURNAMENT_LENGTH_BUCKETS; ++b) {
+                result->lengthHistogram[b] += partial->lengthHistogram[b];
+            }
+        }
+    } else {
+        printf("Failed to set up the tournament!\n");
+        freeTournamentResult(result);
+    }
+
+    for (int w = 0; w < ready; ++w) {
+        freeGame(&task.games[w]);
+        freeTournamentResult(&task.partials[w]);
+    }
+    free(task.games);
+    free(task.partials);
+    destroyThreadPool(pool);
+    return ok;
+}
+
+int tournamentScorePercentile(const TournamentResult *result, double p) {
+    long target = (long)(p * result->games);
+    long seen = 0;
+    for (int s = 0; s <= result->numBricks; ++s) {
+        seen += result->scoreHistogram[s];
+        if (seen > target) {
+            return s;
+        }
+    }
+    return result->numBricks;
+}
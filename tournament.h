@@ -0,0 +1,48 @@
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "autopilot.h"
+#include "level.h"
+
+// Many seeded games of one autopilot, spread over every core, to measure
+// how hard a level is. Game g uses seed firstSeed + g and launches the
+// ball at a random angle, so results depend only on the settings and not
+// on the thread count.
+typedef struct {
+    int numGames;
+    uint32_t firstSeed;
+    int numBricks;
+    const Level *level;   // Bricks of a level file instead of numBricks built-in ones
+    float dt;             // Seconds per step
+    float maxGameTime;    // Games still running after this many seconds are cut off
+    float powerUpChance;
+    int numThreads;       // 0: one per hardware thread
+} TournamentSettings;
+
+// Game lengths are counted in this many equal buckets up to maxGameTime
+#define TOURNAMENT_LENGTH_BUCKETS 40
+
+typedef struct {
+    long games;
+    long wins;
+    long timeouts;           // Cut off at maxGameTime
+    long long totalScore;
+    double totalTime;        // Game seconds
+    long long totalSteps;
+    int numBricks;
+    long *scoreHistogram;    // numBricks + 1 entries; a point per brick, so
+                             // this is also the bricks destroyed
+    long lengthHistogram[TOURNAMENT_LENGTH_BUCKETS];
+} TournamentResult;
+
+// Play the games; false (with a message) if memory runs out
+bool runTournament(const TournamentSettings *settings, Autopilot autopilot, TournamentResult *result);
+void freeTournamentResult(TournamentResult *result);
+
+// Score below which a fraction p of the games ended
+int tournamentScorePercentile(const TournamentResult *result, double p);
+
+#endif